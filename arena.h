@@ -0,0 +1,282 @@
+/**
+ * @file arena.h
+ * @brief Per-solve pool allocator for the containers of the search
+ * algorithms.
+ * 
+ * Each solver owns an Arena and activates it with an Arena::Scope.
+ * While the scope is active, every container built on ArenaAllocator takes
+ * its memory from the arena instead of the general heap: the store's table,
+ * the open buckets, the expandable sets, the queues and the successor
+ * vectors. Freed chunks go on a free list for their size class and are
+ * handed out again, and the arena returns all of its blocks in one step
+ * when it is destroyed. Containers that outlive a single scope, such as the
+ * members of a solver, are constructed with make(). Containers built
+ * outside any scope fall back to operator new and delete.
+ * 
+ * @author Andrew Gu (andrewg2)
+ * @bug No known bugs.
+ */
+
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <utility>
+#include <cstddef>
+#include <new>
+
+/**
+ * @brief Allocation statistics of an arena.
+ */
+struct ArenaStats {
+    /** @brief number of chunks handed out */
+    int allocations;
+    /** @brief number of chunks handed out from a free list */
+    int reused;
+    /** @brief number of blocks taken from the general heap */
+    int blocks;
+    /** @brief total size of those blocks in bytes */
+    std::size_t bytes;
+
+    /**
+     * @brief Constructor.
+     */
+    ArenaStats()
+        : allocations(0), reused(0), blocks(0), bytes(0)
+    {}
+};
+
+/**
+ * @brief Pool allocator with power-of-two size classes.
+ * 
+ * Chunks are carved from large blocks by bumping a pointer. A freed chunk is
+ * pushed on the free list of its size class, so the buffers dropped by a
+ * growing vector and the successor vectors of each expansion are recycled
+ * without touching the general heap.
+ */
+class Arena {
+public:
+    /**
+     * @brief Makes the arena current for the lifetime of the scope.
+     */
+    class Scope {
+    public:
+        /**
+         * @brief Constructor.
+         */
+        explicit Scope(Arena &arena)
+            : previous_(current_)
+        {
+            current_ = &arena;
+        }
+
+        /**
+         * @brief Destructor; restores the previously current arena.
+         */
+        ~Scope() {
+            current_ = previous_;
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        Arena *previous_;
+    };
+
+    /**
+     * @brief Constructor.
+     *
+     * @param stats Statistics to update as chunks and blocks are handed out.
+     */
+    explicit Arena(ArenaStats &stats)
+        : stats_(stats), top_(nullptr), end_(nullptr)
+    {
+        for (void *&head : free_) {
+            head = nullptr;
+        }
+    }
+
+    /**
+     * @brief Destructor; returns every block to the general heap.
+     */
+    ~Arena() {
+        for (void *block : blocks_) {
+            ::operator delete(block);
+        }
+    }
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    /**
+     * @brief Gets the arena of the innermost active scope, or nullptr.
+     */
+    static Arena *get_current() {
+        return current_;
+    }
+
+    /**
+     * @brief Constructs an object whose containers take their memory from
+     * this arena.
+     */
+    template <class T, class... Args>
+    T make(Args &&... args) {
+        Scope scope(*this);
+        return T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Hands out a chunk of at least the given size, aligned for any
+     * type.
+     */
+    void *allocate(std::size_t size) {
+        int c = get_class(size);
+        stats_.allocations++;
+        if (free_[c] != nullptr) {
+            void *chunk = free_[c];
+            free_[c] = *static_cast<void **>(chunk);
+            stats_.reused++;
+            return chunk;
+        }
+
+        std::size_t chunk_size = std::size_t(1) << c;
+        if (chunk_size > BLOCK_SIZE / 4) {
+            return new_block(chunk_size);
+        }
+        if (static_cast<std::size_t>(end_ - top_) < chunk_size) {
+            top_ = static_cast<char *>(new_block(BLOCK_SIZE));
+            end_ = top_ + BLOCK_SIZE;
+        }
+        void *chunk = top_;
+        top_ += chunk_size;
+        return chunk;
+    }
+
+    /**
+     * @brief Puts a chunk handed out for the given size on its free list.
+     */
+    void deallocate(void *chunk, std::size_t size) {
+        int c = get_class(size);
+        *static_cast<void **>(chunk) = free_[c];
+        free_[c] = chunk;
+    }
+
+private:
+    /** @brief size of the blocks that small chunks are carved from */
+    static const std::size_t BLOCK_SIZE = 1 << 20;
+    /** @brief log2 of the smallest chunk size */
+    static const int MIN_CLASS = 4;
+    /** @brief number of size classes */
+    static const int NUM_CLASSES = 8 * sizeof(std::size_t);
+
+    /**
+     * @brief Gets the size class of the given size, i.e. the log2 of the
+     * smallest power of two that holds it.
+     */
+    static int get_class(std::size_t size) {
+        int c = MIN_CLASS;
+        while ((std::size_t(1) << c) < size) {
+            c++;
+        }
+        return c;
+    }
+
+    /**
+     * @brief Takes a block of the given size from the general heap.
+     */
+    void *new_block(std::size_t size) {
+        void *block = ::operator new(size);
+        blocks_.push_back(block);
+        stats_.blocks++;
+        stats_.bytes += size;
+        return block;
+    }
+
+    static inline thread_local Arena *current_ = nullptr;
+
+    ArenaStats &stats_;
+    std::vector<void *> blocks_;
+    void *free_[NUM_CLASSES];
+    char *top_;
+    char *end_;
+};
+
+/**
+ * @brief Standard allocator backed by the arena that was current when it was
+ * constructed.
+ */
+template <class T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    /**
+     * @brief Constructor; binds to the current arena, if any.
+     */
+    ArenaAllocator()
+        : arena_(Arena::get_current())
+    {}
+
+    /**
+     * @brief Converting constructor used by the standard containers.
+     */
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U> &other)
+        : arena_(other.get_arena())
+    {}
+
+    /**
+     * @brief Allocates storage for n objects.
+     */
+    T *allocate(std::size_t n) {
+        if (arena_ == nullptr) {
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+        }
+        return static_cast<T *>(arena_->allocate(n * sizeof(T)));
+    }
+
+    /**
+     * @brief Frees storage for n objects.
+     */
+    void deallocate(T *p, std::size_t n) {
+        if (arena_ == nullptr) {
+            ::operator delete(p);
+        } else {
+            arena_->deallocate(p, n * sizeof(T));
+        }
+    }
+
+    /**
+     * @brief Gets the arena, or nullptr for the general heap.
+     */
+    Arena *get_arena() const {
+        return arena_;
+    }
+
+private:
+    Arena *arena_;
+};
+
+/**
+ * @brief Two allocators are equal iff they share an arena.
+ */
+template <class T, class U>
+bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+    return a.get_arena() == b.get_arena();
+}
+
+/**
+ * @brief Two allocators are equal iff they share an arena.
+ */
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+    return a.get_arena() != b.get_arena();
+}
+
+/* typedef for convenience */
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+template <class K, class V, class Hash>
+using ArenaMap = std::unordered_map<K, V, Hash, std::equal_to<K>, ArenaAllocator<std::pair<const K, V>>>;
@@ -1,163 +1,455 @@
 /**
  * @file astar.cpp
- * @brief A* implementation for the n-puzzle problem.
+ * @brief A* implementation, generic over the search domain.
  * 
- * There is a repeated code between this file and puzzle.cpp, the reason being
- * that this A* implementation prefers each node to store its g and h values
- * to be used in the priority queue priority computation (whereas previously
- * the g values were stored separately and the h values were computed on the
- * fly).
+ * Nodes are expanded with the domain's expand() in the forward direction;
+ * their g is tracked beside them and h_F is read from the node.
  * 
  * @author Andrew Gu (andrewg2)
  * @bug No known bugs.
  */
 
-#include "a_star.h"
+#include "astar.h"
+#include "puzzle.h"
+#include "pancake.h"
 
-#include <queue>
+#include <thread>
 #include <limits.h>
+#include <assert.h>
 
 /**
- * @brief Node used in A*.
+ * @brief Constructor.
  * 
- * This is made separate from the Node struct defined in pancake.h since the
- * nodes in A* must track their own g and h values for storage in a priority
- * queue.
+ * @param discount Used for degrading the heuristic.
+ * @param kinds Kind of heuristic of each direction.
  */
-struct AStarNode {
-    /** @brief state representing a pancake stack */
-    std::vector<int> s;
-    /** @brief cost of path so far */
-    int g;
-    /** @brief heuristic cost */
-    int h;
-
-    /**
-     * @brief Constructor.
-     */
-    AStarNode(const std::vector<int> &s, int g, int h)
-        : s(s), g(g), h(h)
-    {}
-};
+template <class Store>
+AStarSolver<Store>::AStarSolver(int discount, const HeuristicKinds &kinds)
+    : discount_(discount), kinds_(kinds), arena_(counters_.arena),
+      store_(arena_.make<Store>()),
+      open_(arena_.make<BucketQueue<P>>())
+{}
 
 /**
- * @brief Comparison function for A* nodes.
+ * @brief Clears the store and the open list, keeping their memory for the
+ * next solve.
+ * 
+ * @return Void.
  */
-struct AStarNodeCompare {
-    /**
-     * @brief A node with lower f = g + h has higher priority.
-     */
-    bool operator()(const AStarNode &node1, const AStarNode &node2) {
-        return node1.g + node1.h > node2.g + node2.h;
-    }
-};
+template <class Store>
+void AStarSolver<Store>::reset() {
+    store_.clear();
+    open_.clear();
+}
 
 /**
- * @brief Hash function for AStarNode.
+ * @brief Runs the A* algorithm with the given initial and goal state.
+ * 
+ * Only the forward direction of the store is used: g_F is the best-g table
+ * and closed_F the set of expanded states. Successors whose g is no better
+ * than the best known are dropped before they are pushed, and popped nodes
+ * whose state was already expanded or reached more cheaply are skipped.
+ * Assumes a consistent heuristic, so an expanded state is never reached
+ * more cheaply.
+ * 
+ * @param initial_state Initial state.
+ * @param goal_state Goal state.
+ * @return Optimal cost.
  */
-struct AStarNodeHash {
-    /**
-     * @brief Hash a node based only on its state s.
-     */
-    std::size_t operator()(const AStarNode &node) const {
-        std::size_t seed = node.s.size();
-        for (int i : node.s) {
-            seed ^= i + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-        }
-        return seed;
-    }
-};
+template <class Store>
+int AStarSolver<Store>::solve(State initial_state, State goal_state) {
+    counters_ = Counters();
 
-/**
- * @brief Equality function for AStarNode.
- */
-struct AStarNodeEqual {
-    /**
-     * @brief Two nodes are equal iff their states s are the same.
-     */
-    bool operator()(const AStarNode &node1, const AStarNode &node2) const {
-        if (node1.s.size() != node2.s.size()) {
-            return false;
+    /* containers built during the solve take their memory from the arena */
+    Arena::Scope scope(arena_);
+    reset();
+    typename P::Heuristic heuristic(initial_state, goal_state, discount_, kinds_);
+
+    Node initial_node = P::make_root(initial_state, Direction::F, heuristic);
+    store_.set_g(store_.insert(initial_state, initial_node.hash), Direction::F, 0);
+    open_.push(initial_node, 0);
+    counters_.nodes_pushed++;
+    while (!open_.empty()) {
+        int g;
+        Node node = open_.pop(g);
+
+        /* skip stale duplicates */
+        Handle node_h = store_.find(node.s, node.hash);
+        if (store_.is_closed(node_h, Direction::F) || store_.get_g(node_h, Direction::F) < g) {
+            counters_.stale_popped++;
+            continue;
         }
-        int s_size = node1.s.size();
-        for (int i = 0; i < s_size; ++i) {
-            if (node1.s[i] != node2.s[i]) {
-                return false;
+        store_.close(node_h, Direction::F);
+        if (P::is_solved(node.s, goal_state)) {
+            return g;
+        }
+        
+        typename P::NodeVector successors = P::expand(node, heuristic, counters_);
+        for (const Node &s_node : successors) {
+            /* drop successors dominated by a known path */
+            Handle h = store_.insert(s_node.s, s_node.hash);
+            if (store_.has_g(h, Direction::F) && store_.get_g(h, Direction::F) <= g + 1) {  // assumes unit cost
+                continue;
             }
+            assert(!store_.is_closed(h, Direction::F));
+            store_.set_g(h, Direction::F, g + 1);
+            open_.push(s_node, g + 1);
+            counters_.nodes_pushed++;
         }
-        return true;
     }
-};
 
-/* typedef for convenience */
-typedef std::priority_queue<AStarNode,std::vector<AStarNode>,AStarNodeCompare> PQ;
-typedef std::vector<AStarNode> AStarNodeVector;
+    return INT_MAX;  // unsolvable
+}
 
 /**
- * @brief Expands the given node and returns its successors.
+ * @brief Runs the A* algorithm with the given initial and goal state on a
+ * solver of its own.
  * 
- * @param node Node to expand.
- * @param gs Goal state.
+ * @param initial_state Initial state.
+ * @param goal_state Goal state.
  * @param discount Used for degrading the heuristic.
- * @param nodes_expanded (output) Number of nodes expanded so far.
- * @return Vector of successor nodes.
+ * @param kinds Kind of heuristic of each direction.
+ * @param counters To be set to the counters of the search.
+ * @return Optimal cost.
  */
-AStarNodeVector expand(const AStarNode &node, const std::vector<int> &gs, int discount, int &nodes_expanded) {
-    nodes_expanded++;
-    int row, col;
-    get_pos(node.s, 0, row, col);
-    AStarNodeVector successors;
-    if (is_valid_up(row)) {
-        std::vector<int> up_successor = make_move(node.s, Move::Up);
-        successors.emplace_back(up_successor, node.g + 1, h(up_successor, gs, discount));
-    }
-    if (is_valid_down(row)) {
-        std::vector<int> down_successor = make_move(node.s, Move::Down);
-        successors.emplace_back(down_successor, node.g + 1, h(down_successor, gs, discount));
-    }
-    if (is_valid_left(col)) {
-        std::vector<int> left_successor = make_move(node.s, Move::Left);
-        successors.emplace_back(left_successor, node.g + 1, h(left_successor, gs, discount));
-    }
-    if (is_valid_right(col)) {
-        std::vector<int> right_successor = make_move(node.s, Move::Right);
-        successors.emplace_back(right_successor, node.g + 1, h(right_successor, gs, discount));
-    }
-    return successors;
+template <class Store>
+int astar(typename Store::State initial_state, typename Store::State goal_state, int discount, const HeuristicKinds &kinds, Counters &counters) {
+    AStarSolver<Store> solver(discount, kinds);
+    int cost = solver.solve(initial_state, goal_state);
+    counters = solver.get_counters();
+    return cost;
 }
 
+/**
+ * @brief Constructor.
+ * 
+ * @param discount Used for degrading the heuristic.
+ * @param kinds Kind of heuristic of each direction.
+ * @param num_threads Number of workers, or 0 for one per hardware thread.
+ */
+template <class Store>
+HdaStarSolver<Store>::HdaStarSolver(int discount, const HeuristicKinds &kinds, int num_threads)
+    : discount_(discount), kinds_(kinds), num_threads_(num_threads), work_(0)
+{
+    if (num_threads_ <= 0) {
+        num_threads_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (int t = 0; t < num_threads_; ++t) {
+        workers_.emplace_back(new Worker());
+        workers_[t]->outbox.resize(num_threads_);
+    }
+}
 
 /**
- * @brief Runs the A* algorithm with the given initial and goal state.
+ * @brief Runs HDA* with the given initial and goal state.
  * 
  * @param initial_state Initial state.
  * @param goal_state Goal state.
- * @param eps Integer representing the minimum-cost operator in the domain,
- * i.e. the cheapest edge in the state space.
- * @param gap_x x for the GAP-x heuristic.
- * @param nodes_expanded To be set to the number of nodes expanded.
  * @return Optimal cost.
  */
-int astar(const std::vector<int> &initial_state, const std::vector<int> &goal_state, int discount, int &nodes_expanded) {
-    std::unordered_set<AStarNode,AStarNodeHash,AStarNodeEqual> visited;
-
-    PQ pq;
-    pq.emplace(initial_state, 0, h(initial_state, goal_state, discount));
-    while (!pq.empty()) {
-        AStarNode node = pq.top();
-        pq.pop();
-        visited.insert(node);
-        if (is_solved(node.s, goal_state)) {
-            return node.g;
+template <class Store>
+int HdaStarSolver<Store>::solve(State initial_state, State goal_state) {
+    counters_ = Counters();
+    incumbent_.reset();
+    for (std::unique_ptr<Worker> &worker : workers_) {
+        Arena::Scope scope(worker->arena);
+        worker->counters = Counters();
+        worker->store.clear();
+        worker->open.clear();
+        worker->floor = INT_MAX;
+        worker->inbound = INT_MAX;
+    }
+    typename P::Heuristic heuristic(initial_state, goal_state, discount_, kinds_);
+
+    /* the owner of the initial state starts with it */
+    Node initial_node = P::make_root(initial_state, Direction::F, heuristic);
+    Worker &owner = *workers_[get_owner(initial_node.hash)];
+    {
+        Arena::Scope scope(owner.arena);
+        receive(owner, Message{initial_node, 0});
+        publish(owner);
+    }
+
+    /* every worker starts out active */
+    work_ = num_threads_;
+    std::vector<std::thread> threads;
+    for (int t = 1; t < num_threads_; ++t) {
+        threads.emplace_back([&, t]() {
+            run_worker(t, heuristic, goal_state);
+        });
+    }
+    run_worker(0, heuristic, goal_state);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    for (std::unique_ptr<Worker> &worker : workers_) {
+        counters_.add(worker->counters);
+    }
+    return incumbent_.get();
+}
+
+/**
+ * @brief Main loop of one worker.
+ * 
+ * The worker queues the batches in its inbox, then expands its best node if
+ * that node could still lead to a cheaper solution than the incumbent and
+ * no worker may hold or be sent a node with a smaller f; otherwise it sends
+ * its partial batches and waits. Since a consistent heuristic never gives
+ * a successor a smaller f than its parent, the smallest published f only
+ * grows, and the worker checks it again only once its own best node is
+ * above the last value read. Once the worker has no node below the
+ * incumbent, it goes idle, until a batch arrives or the work counter says
+ * that every worker is idle.
+ * 
+ * @param t Index of the worker.
+ * @param heuristic Heuristic of the current solve.
+ * @param goal_state Goal state.
+ * @return Void.
+ */
+template <class Store>
+void HdaStarSolver<Store>::run_worker(int t, const typename P::Heuristic &heuristic, const State &goal_state) {
+    Worker &worker = *workers_[t];
+    Arena::Scope scope(worker.arena);
+    bool active = true;
+    int bound = 0;  // smallest published f, as last read
+    while (true) {
+        /* queue the received successors */
+        worker.inbound = INT_MAX;
+        Batch *batch = worker.inbox.take();
+        if (batch != nullptr && !active) {
+            work_++;
+            active = true;
         }
-        
-        AStarNodeVector successors = expand(node, goal_state, discount, nodes_expanded);
-        for (const AStarNode & s_node : successors) {
-            if (visited.count(s_node) == 0) {
-                pq.push(s_node);
+        while (batch != nullptr) {
+            std::unique_ptr<Batch> done(batch);
+            for (const Message &message : batch->messages) {
+                receive(worker, message);
             }
+            batch = batch->next;
+            work_--;
+            publish(worker);
         }
+
+        int fmin = worker.open.get_fmin();
+        if (fmin < incumbent_.get()) {
+            /* wait while another worker may hold or be sent a better node */
+            if (fmin > bound) {
+                publish(worker);
+                bound = get_floor();
+                if (fmin > bound) {
+                    for (int owner = 0; owner < num_threads_; ++owner) {
+                        flush(worker, owner);
+                    }
+                    publish(worker);
+                    std::this_thread::yield();
+                    continue;
+                }
+            }
+
+            int g;
+            Node node = worker.open.pop(g);
+
+            /* skip stale duplicates */
+            Handle node_h = worker.store.find(node.s, node.hash);
+            if (worker.store.get_g(node_h, Direction::F) < g) {
+                worker.counters.stale_popped++;
+                continue;
+            }
+            if (P::is_solved(node.s, goal_state)) {
+                incumbent_.improve(g);
+                continue;
+            }
+
+            /* send each successor that could improve on the incumbent to its owner */
+            typename P::NodeVector successors = P::expand(node, heuristic, worker.counters);
+            for (const Node &s_node : successors) {
+                Message message{s_node, g + 1};  // assumes unit cost
+                if (message.g + s_node.h_F >= incumbent_.get()) {
+                    continue;
+                }
+                int owner = get_owner(s_node.hash);
+                if (owner == t) {
+                    receive(worker, message);
+                } else {
+                    send(worker, owner, message);
+                }
+            }
+
+            /* send the partial batches that hold better nodes than this worker's next one */
+            int fmin = worker.open.get_fmin();
+            bool all = worker.open.size() < SMALL_OPEN;
+            for (int owner = 0; owner < num_threads_; ++owner) {
+                if (worker.outbox[owner] && (all || worker.outbox[owner]->fmin < fmin)) {
+                    flush(worker, owner);
+                }
+            }
+            continue;
+        }
+
+        /* nothing left that could improve on the incumbent */
+        for (int owner = 0; owner < num_threads_; ++owner) {
+            flush(worker, owner);
+        }
+        publish(worker);
+        if (active) {
+            active = false;
+            work_--;
+        }
+        if (work_ == 0) {
+            return;
+        }
+        std::this_thread::yield();
     }
+}
 
-    return INT_MAX;  // unsolvable
-}
\ No newline at end of file
+/**
+ * @brief Queues a successor owned by the worker unless a path at least as
+ * cheap is known.
+ * 
+ * @param worker Worker that owns the successor.
+ * @param message Successor and its cost.
+ * @return Void.
+ */
+template <class Store>
+void HdaStarSolver<Store>::receive(Worker &worker, const Message &message) {
+    Handle h = worker.store.insert(message.node.s, message.node.hash);
+    if (worker.store.has_g(h, Direction::F) && worker.store.get_g(h, Direction::F) <= message.g) {
+        return;
+    }
+    worker.store.set_g(h, Direction::F, message.g);
+    worker.open.push(message.node, message.g);
+    worker.counters.nodes_pushed++;
+}
+
+/**
+ * @brief Adds a successor to the batch for its owner, sending the batch
+ * once it is full.
+ * 
+ * @param worker Sending worker.
+ * @param owner Index of the worker that owns the successor.
+ * @param message Successor and its cost.
+ * @return Void.
+ */
+template <class Store>
+void HdaStarSolver<Store>::send(Worker &worker, int owner, const Message &message) {
+    std::unique_ptr<Batch> &batch = worker.outbox[owner];
+    if (!batch) {
+        batch.reset(new Batch());
+        batch->messages.reserve(BATCH_SIZE);
+        batch->fmin = INT_MAX;
+    }
+    batch->messages.push_back(message);
+    batch->fmin = std::min(batch->fmin, message.g + message.node.h_F);
+    if (batch->messages.size() >= BATCH_SIZE) {
+        flush(worker, owner);
+    }
+}
+
+/**
+ * @brief Sends the partial batch for the given owner, if any.
+ * 
+ * The batch is counted as work before it is pushed, while the sender is
+ * still counted as active, and lowers the bound of the receiver's inbox
+ * before it can be taken.
+ * 
+ * @param worker Sending worker.
+ * @param owner Index of the receiving worker.
+ * @return Void.
+ */
+template <class Store>
+void HdaStarSolver<Store>::flush(Worker &worker, int owner) {
+    std::unique_ptr<Batch> &batch = worker.outbox[owner];
+    if (!batch) {
+        return;
+    }
+    work_++;
+    std::atomic<int> &inbound = workers_[owner]->inbound;
+    int current = inbound.load();
+    while (batch->fmin < current && !inbound.compare_exchange_weak(current, batch->fmin)) {
+    }
+    workers_[owner]->inbox.push(batch.release());
+}
+
+/**
+ * @brief Publishes the smallest f on the worker's open list and in its
+ * partial batches.
+ * 
+ * @param worker Worker to publish.
+ * @return Void.
+ */
+template <class Store>
+void HdaStarSolver<Store>::publish(Worker &worker) {
+    int floor = worker.open.get_fmin();
+    for (const std::unique_ptr<Batch> &batch : worker.outbox) {
+        if (batch) {
+            floor = std::min(floor, batch->fmin);
+        }
+    }
+    worker.floor = floor;
+}
+
+/**
+ * @brief Gets the smallest f that any worker has published or been sent.
+ * 
+ * @return Lower bound on the f of every node left to expand, up to the
+ * values that workers have not published yet.
+ */
+template <class Store>
+int HdaStarSolver<Store>::get_floor() const {
+    int floor = INT_MAX;
+    for (const std::unique_ptr<Worker> &worker : workers_) {
+        floor = std::min(floor, std::min(worker->floor.load(), worker->inbound.load()));
+    }
+    return floor;
+}
+
+/**
+ * @brief Runs HDA* with the given initial and goal state on a solver of its
+ * own.
+ * 
+ * @param initial_state Initial state.
+ * @param goal_state Goal state.
+ * @param discount Used for degrading the heuristic.
+ * @param kinds Kind of heuristic of each direction.
+ * @param num_threads Number of workers, or 0 for one per hardware thread.
+ * @param counters To be set to the counters of the search.
+ * @return Optimal cost.
+ */
+template <class Store>
+int hdastar(typename Store::State initial_state, typename Store::State goal_state, int discount, const HeuristicKinds &kinds, int num_threads, Counters &counters) {
+    HdaStarSolver<Store> solver(discount, kinds, num_threads);
+    int cost = solver.solve(initial_state, goal_state);
+    counters = solver.get_counters();
+    return cost;
+}
+
+/* explicit instantiations */
+template class AStarSolver<HashStore<Puzzle<3>>>;
+template class AStarSolver<HashStore<Puzzle<4>>>;
+template class AStarSolver<HashStore<Puzzle<5>>>;
+template class AStarSolver<DenseStore<Puzzle<3>>>;
+template class AStarSolver<HashStore<Pancake<8>>>;
+template class AStarSolver<HashStore<Pancake<12>>>;
+template class AStarSolver<HashStore<Pancake<16>>>;
+template int astar<HashStore<Puzzle<3>>>(Puzzle<3>::State, Puzzle<3>::State, int, const HeuristicKinds &, Counters &);
+template int astar<HashStore<Puzzle<4>>>(Puzzle<4>::State, Puzzle<4>::State, int, const HeuristicKinds &, Counters &);
+template int astar<HashStore<Puzzle<5>>>(Puzzle<5>::State, Puzzle<5>::State, int, const HeuristicKinds &, Counters &);
+template int astar<DenseStore<Puzzle<3>>>(Puzzle<3>::State, Puzzle<3>::State, int, const HeuristicKinds &, Counters &);
+template int astar<HashStore<Pancake<8>>>(Pancake<8>::State, Pancake<8>::State, int, const HeuristicKinds &, Counters &);
+template int astar<HashStore<Pancake<12>>>(Pancake<12>::State, Pancake<12>::State, int, const HeuristicKinds &, Counters &);
+template int astar<HashStore<Pancake<16>>>(Pancake<16>::State, Pancake<16>::State, int, const HeuristicKinds &, Counters &);
+template class HdaStarSolver<HashStore<Puzzle<3>>>;
+template class HdaStarSolver<HashStore<Puzzle<4>>>;
+template class HdaStarSolver<HashStore<Puzzle<5>>>;
+template class HdaStarSolver<DenseStore<Puzzle<3>>>;
+template class HdaStarSolver<HashStore<Pancake<8>>>;
+template class HdaStarSolver<HashStore<Pancake<12>>>;
+template class HdaStarSolver<HashStore<Pancake<16>>>;
+template int hdastar<HashStore<Puzzle<3>>>(Puzzle<3>::State, Puzzle<3>::State, int, const HeuristicKinds &, int, Counters &);
+template int hdastar<HashStore<Puzzle<4>>>(Puzzle<4>::State, Puzzle<4>::State, int, const HeuristicKinds &, int, Counters &);
+template int hdastar<HashStore<Puzzle<5>>>(Puzzle<5>::State, Puzzle<5>::State, int, const HeuristicKinds &, int, Counters &);
+template int hdastar<DenseStore<Puzzle<3>>>(Puzzle<3>::State, Puzzle<3>::State, int, const HeuristicKinds &, int, Counters &);
+template int hdastar<HashStore<Pancake<8>>>(Pancake<8>::State, Pancake<8>::State, int, const HeuristicKinds &, int, Counters &);
+template int hdastar<HashStore<Pancake<12>>>(Pancake<12>::State, Pancake<12>::State, int, const HeuristicKinds &, int, Counters &);
+template int hdastar<HashStore<Pancake<16>>>(Pancake<16>::State, Pancake<16>::State, int, const HeuristicKinds &, int, Counters &);
\ No newline at end of file
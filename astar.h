@@ -1,6 +1,6 @@
 /**
  * @file astar.h
- * @brief 
+ * @brief Solver and function interface for A*.
  * 
  * @author Andrew Gu (andrewg2)
  * @bug No known bugs.
@@ -8,7 +8,357 @@
 
 #pragma once
 
-#include "puzzle.h"
+#include "domain.h"
+#include "store.h"
+#include "bidir.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <limits.h>
+#include <assert.h>
+
+/**
+ * @brief Open list of A* for integer costs, bucketed by f and then g.
+ * 
+ * A queued node is stored as its packed state, hash, auxiliary byte,
+ * generating move and h_B; its g and h_F are implied by the bucket it sits
+ * in. pop() returns a node with minimal f and, among those, maximal g, so
+ * ties in the final f-layer are broken towards nodes closest to the goal.
+ */
+template <class P>
+class BucketQueue {
+public:
+    typedef typename P::Node Node;
+
+    /**
+     * @brief Constructor.
+     */
+    BucketQueue()
+        : size_(0), f_cursor_(0)
+    {}
+
+    /**
+     * @brief Checks if the queue is empty.
+     */
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    /**
+     * @brief Gets the number of queued nodes.
+     */
+    std::size_t size() const {
+        return size_;
+    }
+
+    /**
+     * @brief Adds the forward node with cost g to bucket (g + h_F, g).
+     */
+    void push(const Node &node, int g) {
+        int f = g + node.h_F;
+        assert(g >= 0 && node.h_F >= 0);
+        if (f >= static_cast<int>(rows_.size())) {
+            rows_.resize(f + 1);
+        }
+        Row &row = rows_[f];
+        if (g >= static_cast<int>(row.buckets.size())) {
+            row.buckets.resize(g + 1);
+        }
+        row.buckets[g].push_back(Entry{node.s, node.hash, P::get_aux(node), static_cast<uint8_t>(node.move), static_cast<uint8_t>(node.h_B)});
+        row.top_g = std::max(row.top_g, g);
+        row.size++;
+        size_++;
+        f_cursor_ = std::min(f_cursor_, f);
+    }
+
+    /**
+     * @brief Removes every node, keeping the buckets allocated.
+     */
+    void clear() {
+        for (Row &row : rows_) {
+            for (ArenaVector<Entry> &bucket : row.buckets) {
+                bucket.clear();
+            }
+            row.top_g = 0;
+            row.size = 0;
+        }
+        size_ = 0;
+        f_cursor_ = 0;
+    }
+
+    /**
+     * @brief Gets the minimum f on the queue, or INT_MAX if it is empty.
+     */
+    int get_fmin() {
+        if (empty()) {
+            return INT_MAX;
+        }
+        while (rows_[f_cursor_].size == 0) {
+            f_cursor_++;
+        }
+        return f_cursor_;
+    }
+
+    /**
+     * @brief Removes and returns a node with minimal f and maximal g.
+     * 
+     * @param g (output) Cost of the node.
+     * @return Forward node.
+     * @pre The queue is not empty.
+     */
+    Node pop(int &g) {
+        assert(!empty());
+        while (rows_[f_cursor_].size == 0) {
+            f_cursor_++;
+        }
+        Row &row = rows_[f_cursor_];
+        while (row.buckets[row.top_g].empty()) {
+            row.top_g--;
+        }
+        ArenaVector<Entry> &bucket = row.buckets[row.top_g];
+        Entry entry = bucket.back();
+        bucket.pop_back();
+        row.size--;
+        size_--;
+        g = row.top_g;
+        return P::make_node(entry.s, entry.hash, entry.aux, entry.move, Direction::F, f_cursor_ - g, entry.h_B);
+    }
+
+private:
+    /**
+     * @brief Queued node.
+     */
+    struct Entry {
+        /** @brief packed state */
+        typename P::State s;
+        /** @brief hash of s */
+        std::size_t hash;
+        /** @brief auxiliary byte of the domain, see P::get_aux() */
+        uint8_t aux;
+        /** @brief move that generated the node from its parent */
+        uint8_t move;
+        /** @brief heuristic estimate of the distance to the initial state */
+        uint8_t h_B;
+    };
+
+    /**
+     * @brief Buckets of one f-value, indexed by g.
+     */
+    struct Row {
+        ArenaVector<ArenaVector<Entry>> buckets;
+        /** @brief upper bound on the largest g with a nonempty bucket */
+        int top_g = 0;
+        /** @brief number of nodes in the row */
+        std::size_t size = 0;
+    };
+
+    ArenaVector<Row> rows_;
+    std::size_t size_;
+    /** @brief lower bound on the smallest f with a nonempty row */
+    int f_cursor_;
+};
+
+/**
+ * @brief Reusable A* solver.
+ * 
+ * The store and the open list live as long as the solver and take their
+ * memory from its arena. solve() clears them with reset(), which keeps the
+ * table and the buckets allocated for the next instance.
+ */
+template <class Store>
+class AStarSolver {
+public:
+    typedef typename Store::Domain P;
+    typedef typename Store::State State;
+    typedef typename P::Node Node;
+
+    AStarSolver(int discount, const HeuristicKinds &kinds);
+    int solve(State initial_state, State goal_state);
+    void reset();
+
+    /**
+     * @brief Gets the counters of the last solve.
+     */
+    const Counters &get_counters() const {
+        return counters_;
+    }
+
+private:
+    int discount_;
+    HeuristicKinds kinds_;
+    Counters counters_;
+    Arena arena_;
+    Store store_;
+    BucketQueue<P> open_;
+};
+
+/**
+ * @brief Reusable hash-distributed parallel A* (HDA*) solver.
+ * 
+ * Every state is owned by one worker, chosen by its hash, and only its
+ * owner keeps its g-value and queues it. A worker expands its own nodes in
+ * f-order and sends each successor to the successor's owner; successors
+ * are collected per destination and handed over in batches through a
+ * lock-free inbox per worker. A goal expanded by any worker becomes the
+ * incumbent, and workers keep expanding nodes with f below it until every
+ * worker is out of such nodes and no batch is in flight, at which point
+ * the incumbent is optimal for a consistent heuristic.
+ * 
+ * Workers do not run ahead of the f-frontier: each publishes the smallest f
+ * on its open list and in its partial batches, senders lower the bound of
+ * each inbox they push to, and a worker only expands a node whose f is no
+ * greater than every published value. A worker that has to wait sends its
+ * partial batches, so the worker holding the smallest f can always go on.
+ * Partial batches are also sent as soon as they hold a node better than the
+ * sender's next one, or when the sender's open list runs low.
+ * 
+ * Termination is detected with a single counter of active workers plus
+ * batches in flight: a worker counts itself before it takes a batch while
+ * idle, and a batch is counted by its sender before it is pushed and
+ * uncounted by its receiver once its nodes are queued, so the counter only
+ * reaches zero when no work is left anywhere.
+ */
+template <class Store>
+class HdaStarSolver {
+public:
+    typedef typename Store::Domain P;
+    typedef typename Store::State State;
+    typedef typename P::Node Node;
+
+    HdaStarSolver(int discount, const HeuristicKinds &kinds, int num_threads);
+    int solve(State initial_state, State goal_state);
+
+    /**
+     * @brief Gets the counters of the last solve, summed over the workers.
+     */
+    const Counters &get_counters() const {
+        return counters_;
+    }
+
+    /**
+     * @brief Gets the number of workers.
+     */
+    int get_num_threads() const {
+        return num_threads_;
+    }
+
+private:
+    /** @brief number of successors collected for a worker before they are
+     * sent */
+    static const std::size_t BATCH_SIZE = 64;
+    /** @brief size of the open list below which partial batches are sent
+     * after every expansion */
+    static const std::size_t SMALL_OPEN = 64;
+
+    /**
+     * @brief Successor sent to its owner, with its cost.
+     */
+    struct Message {
+        Node node;
+        int g;
+    };
+
+    /**
+     * @brief Batch of messages for one worker, linked into its inbox.
+     */
+    struct Batch {
+        Batch *next;
+        std::vector<Message> messages;
+        /** @brief smallest f of the messages */
+        int fmin;
+    };
+
+    /**
+     * @brief Lock-free inbox with many senders and one receiver.
+     * 
+     * Senders push batches onto a stack with compare-and-swap, and the
+     * receiver takes the whole stack at once, so no node of the stack is
+     * ever popped by itself and the stack cannot suffer from ABA.
+     */
+    class Inbox {
+    public:
+        Inbox()
+            : head_(nullptr)
+        {}
+
+        /**
+         * @brief Pushes a batch.
+         */
+        void push(Batch *batch) {
+            batch->next = head_.load(std::memory_order_relaxed);
+            while (!head_.compare_exchange_weak(batch->next, batch, std::memory_order_release, std::memory_order_relaxed)) {
+            }
+        }
+
+        /**
+         * @brief Takes every batch pushed so far, or nullptr if there is none.
+         */
+        Batch *take() {
+            if (head_.load(std::memory_order_relaxed) == nullptr) {
+                return nullptr;
+            }
+            return head_.exchange(nullptr, std::memory_order_acquire);
+        }
+
+    private:
+        std::atomic<Batch *> head_;
+    };
+
+    /**
+     * @brief Arena, store, open list, inbox and outgoing batches of one
+     * worker.
+     */
+    struct Worker {
+        Counters counters;
+        Arena arena;
+        Store store;
+        BucketQueue<P> open;
+        Inbox inbox;
+        std::vector<std::unique_ptr<Batch>> outbox;
+        /** @brief smallest f on the open list and in the outbox, as last
+         * published */
+        std::atomic<int> floor;
+        /** @brief lower bound on the smallest f of the batches in the inbox */
+        std::atomic<int> inbound;
+
+        Worker()
+            : arena(counters.arena), store(arena.make<Store>()),
+              open(arena.make<BucketQueue<P>>()), floor(INT_MAX), inbound(INT_MAX)
+        {}
+    };
+
+    /**
+     * @brief Gets the worker that owns the state with the given hash.
+     * 
+     * The hash is mixed first, since the stores index their tables by its
+     * low bits.
+     */
+    int get_owner(std::size_t hash) const {
+        uint64_t mixed = static_cast<uint64_t>(hash) * 0x9e3779b97f4a7c15ULL;
+        return static_cast<int>((mixed >> 32) % num_threads_);
+    }
+
+    void run_worker(int t, const typename P::Heuristic &heuristic, const State &goal_state);
+    void receive(Worker &worker, const Message &message);
+    void send(Worker &worker, int owner, const Message &message);
+    void flush(Worker &worker, int owner);
+    void publish(Worker &worker);
+    int get_floor() const;
+
+    int discount_;
+    HeuristicKinds kinds_;
+    int num_threads_;
+    Counters counters_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    /** @brief active workers plus batches in flight */
+    std::atomic<int> work_;
+    Incumbent incumbent_;
+};
 
 /* exported function prototypes */
-int astar(const std::vector<int> &initial_state, const std::vector<int> &goal_state, int gap_x, int &nodes_expanded);
\ No newline at end of file
+template <class Store>
+int astar(typename Store::State initial_state, typename Store::State goal_state, int discount, const HeuristicKinds &kinds, Counters &counters);
+template <class Store>
+int hdastar(typename Store::State initial_state, typename Store::State goal_state, int discount, const HeuristicKinds &kinds, int num_threads, Counters &counters);
\ No newline at end of file
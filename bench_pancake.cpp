@@ -0,0 +1,280 @@
+/**
+ * @file bench_pancake.cpp
+ * @brief Benchmarks the byte-packed pancake stack operations against the
+ * vector ones.
+ *
+ * For stacks of 16, 32 and 63 pancakes, times the flip, the flip together
+ * with the hash of the successor, and the comparison of two equal stacks
+ * with std::vector<int> stacks and Zobrist hashes, which the pancake domain
+ * used before it was packed, the scalar packed code and, when built, the
+ * vectorized packed code. Before timing, every flip of every stack is
+ * checked to agree across the versions.
+ *
+ * Usage: make bench_pancake && ./bench_pancake [rounds]
+ *
+ * @author Andrew Gu (andrewg2)
+ * @bug No known bugs.
+ */
+
+#include "stack.h"
+
+#include <chrono>
+#include <random>
+#include <numeric>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+
+/** @brief random stacks per size */
+#define NUM_STACKS (1000)
+
+/** @brief largest vector stack, counting the plate */
+#define MAX_STACK (64)
+
+/** @brief Zobrist table of the vector stacks */
+typedef std::array<std::array<uint64_t, MAX_STACK>, MAX_STACK> ZobristTable;
+
+/**
+ * @brief Builds the Zobrist table of the vector stacks with a splitmix64
+ * generator run at compile time.
+ */
+constexpr ZobristTable make_zobrist_table() {
+    ZobristTable table {};
+    uint64_t x = 0;
+    for (int i = 0; i < MAX_STACK; ++i) {
+        for (int p = 0; p < MAX_STACK; ++p) {
+            uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            table[i][p] = z ^ (z >> 31);
+        }
+    }
+    return table;
+}
+
+/** @brief ZOBRIST[i][p] is the key of pancake p at position i */
+constexpr ZobristTable ZOBRIST = make_zobrist_table();
+
+/**
+ * @brief Performs a k-flip on a vector stack.
+ */
+std::vector<int> flip(const std::vector<int> &s, int k) {
+    std::vector<int> s_flip(s.begin(), s.end());
+    int i = 0;
+    int j = k;
+    while (i < j) {
+        std::swap(s_flip[i++], s_flip[j--]);
+    }
+    return s_flip;
+}
+
+/**
+ * @brief Computes the Zobrist hash of a vector stack from scratch.
+ */
+std::size_t get_hash(const std::vector<int> &s) {
+    std::size_t hash = 0;
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        hash ^= ZOBRIST[i][s[i]];
+    }
+    return hash;
+}
+
+/**
+ * @brief Computes the Zobrist hash of a k-flip of a vector stack in O(k).
+ */
+std::size_t get_flip_hash(const std::vector<int> &s, std::size_t hash, int k) {
+    for (int i = 0; i <= k; ++i) {
+        hash ^= ZOBRIST[i][s[i]] ^ ZOBRIST[i][s[k - i]];
+    }
+    return hash;
+}
+
+/**
+ * @brief Compares two vector stacks one pancake at a time.
+ */
+bool is_solved(const std::vector<int> &s, const std::vector<int> &g) {
+    if (s.size() != g.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        if (s[i] != g[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Makes random stacks of n pancakes, each ending with the plate.
+ */
+std::vector<std::vector<int>> make_stacks(int n) {
+    std::mt19937 rng(n);
+    std::vector<std::vector<int>> stacks;
+    for (int i = 0; i < NUM_STACKS; ++i) {
+        std::vector<int> s(n + 1);
+        std::iota(s.begin(), s.end(), 0);
+        std::shuffle(s.begin(), s.end() - 1, rng);
+        stacks.push_back(s);
+    }
+    return stacks;
+}
+
+/**
+ * @brief Times a benchmark and prints its time per operation.
+ *
+ * @param name Name of the benchmark.
+ * @param ops Operations performed by one call of fn.
+ * @param rounds Number of calls.
+ * @param fn Benchmark returning a checksum, which is printed so that the
+ * work cannot be optimized away.
+ * @return Void.
+ */
+template <class Fn>
+void run_timed(const std::string &name, long ops, int rounds, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    std::size_t checksum = 0;
+    for (int r = 0; r < rounds; ++r) {
+        checksum += fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    printf("  %-28s %8.2f ns/op  (checksum %zx)\n", name.c_str(), ns / (ops * rounds), checksum);
+}
+
+/**
+ * @brief Checks that the packed operations agree with the vector ones on
+ * every flip of the given stacks.
+ */
+template <int CAP>
+void check(const std::vector<std::vector<int>> &stacks, int n) {
+    for (const std::vector<int> &s : stacks) {
+        Stack<CAP> packed = pack_stack<CAP>(s);
+        for (int k = 1; k < n; ++k) {
+            Stack<CAP> expected = pack_stack<CAP>(flip(s, k));
+            Stack<CAP> flipped = flip_scalar(packed, k);
+            bool ok = equal_scalar(flipped, expected) && unpack_stack(flipped, n) == flip(s, k);
+#if STACK_SIMD
+            Stack<CAP> flipped_simd = flip_simd(packed, k);
+            ok = ok && equal_scalar(flipped_simd, expected) && equal_simd(flipped_simd, expected);
+            ok = ok && !equal_simd(flipped_simd, packed);
+            ok = ok && hash_crc32(flipped_simd) == hash_crc32(expected);
+#endif
+            if (!ok) {
+                printf("mismatch: n = %d, k = %d\n", n, k);
+                exit(1);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Runs the benchmarks for stacks of n pancakes.
+ */
+template <int CAP>
+void bench(int n, int rounds) {
+    std::vector<std::vector<int>> stacks = make_stacks(n);
+    check<CAP>(stacks, n);
+    std::vector<Stack<CAP>> packed;
+    std::vector<std::size_t> hashes;
+    for (const std::vector<int> &s : stacks) {
+        packed.push_back(pack_stack<CAP>(s));
+        hashes.push_back(get_hash(s));
+    }
+    std::vector<std::vector<int>> copies = stacks;
+    std::vector<Stack<CAP>> packed_copies = packed;
+    long flips = long(NUM_STACKS) * (n - 1);
+
+    printf("n = %d (%d bytes packed)\n", n, CAP);
+    run_timed("flip vector", flips, rounds, [&]() {
+        std::size_t sum = 0;
+        for (const std::vector<int> &s : stacks) {
+            for (int k = 1; k < n; ++k) {
+                sum += flip(s, k)[0];
+            }
+        }
+        return sum;
+    });
+    run_timed("flip packed scalar", flips, rounds, [&]() {
+        std::size_t sum = 0;
+        for (const Stack<CAP> &s : packed) {
+            for (int k = 1; k < n; ++k) {
+                sum += flip_scalar(s, k).p[0];
+            }
+        }
+        return sum;
+    });
+#if STACK_SIMD
+    run_timed("flip packed simd", flips, rounds, [&]() {
+        std::size_t sum = 0;
+        for (const Stack<CAP> &s : packed) {
+            for (int k = 1; k < n; ++k) {
+                sum += flip_simd(s, k).p[0];
+            }
+        }
+        return sum;
+    });
+#endif
+
+    run_timed("flip+hash vector zobrist", flips, rounds, [&]() {
+        std::size_t sum = 0;
+        for (int i = 0; i < NUM_STACKS; ++i) {
+            for (int k = 1; k < n; ++k) {
+                sum += flip(stacks[i], k)[0] + get_flip_hash(stacks[i], hashes[i], k);
+            }
+        }
+        return sum;
+    });
+    run_timed("flip+hash packed scalar", flips, rounds, [&]() {
+        std::size_t sum = 0;
+        for (const Stack<CAP> &s : packed) {
+            for (int k = 1; k < n; ++k) {
+                sum += hash_scalar(flip_scalar(s, k));
+            }
+        }
+        return sum;
+    });
+#if STACK_SIMD
+    run_timed("flip+hash packed crc32", flips, rounds, [&]() {
+        std::size_t sum = 0;
+        for (const Stack<CAP> &s : packed) {
+            for (int k = 1; k < n; ++k) {
+                sum += hash_crc32(flip_simd(s, k));
+            }
+        }
+        return sum;
+    });
+#endif
+
+    run_timed("equal vector", NUM_STACKS, rounds * n, [&]() {
+        std::size_t sum = 0;
+        for (int i = 0; i < NUM_STACKS; ++i) {
+            sum += is_solved(stacks[i], copies[i]);
+        }
+        return sum;
+    });
+    run_timed("equal packed scalar", NUM_STACKS, rounds * n, [&]() {
+        std::size_t sum = 0;
+        for (int i = 0; i < NUM_STACKS; ++i) {
+            sum += equal_scalar(packed[i], packed_copies[i]);
+        }
+        return sum;
+    });
+#if STACK_SIMD
+    run_timed("equal packed simd", NUM_STACKS, rounds * n, [&]() {
+        std::size_t sum = 0;
+        for (int i = 0; i < NUM_STACKS; ++i) {
+            sum += equal_simd(packed[i], packed_copies[i]);
+        }
+        return sum;
+    });
+#endif
+}
+
+int main(int argc, char *argv[]) {
+    int rounds = (argc > 1) ? atoi(argv[1]) : 100;
+    printf("vectorized stack operations: %s\n", STACK_SIMD ? "on" : "off");
+    bench<16>(16, rounds);
+    bench<32>(32, rounds);
+    bench<64>(63, rounds);
+    return 0;
+}
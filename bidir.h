@@ -0,0 +1,202 @@
+/**
+ * @file bidir.h
+ * @brief Tables kept by the workers of the parallel searches.
+ *
+ * In its concurrent mode, MMe runs each direction on a worker of its own
+ * and replays their expansions in the order of the serial loop, and the
+ * backward worker keeps what it overwrote in its store in a StateTable, so
+ * the replay can see the store as it was. The workers of HDA* share an
+ * Incumbent, which holds the cheapest solution found so far and tells them
+ * all when to stop.
+ *
+ * @author Andrew Gu (andrewg2)
+ * @bug No known bugs.
+ */
+
+#pragma once
+
+#include "domain.h"
+#include "arena.h"
+
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <limits.h>
+
+/**
+ * @brief Map from states to small values, for the bookkeeping of a single
+ * thread.
+ *
+ * An open-addressing table placed by the hash that nodes carry, so no
+ * state is rehashed. Slots are stamped like those of HashStore, so clear()
+ * does not have to touch the slots that a larger round left allocated.
+ */
+template <class State, class V>
+class StateTable {
+public:
+    /**
+     * @brief Constructor.
+     */
+    StateTable()
+        : slots_(MIN_CAPACITY), size_(0), stamp_(1)
+    {}
+
+    /**
+     * @brief Removes every entry, keeping the table allocated.
+     */
+    void clear() {
+        stamp_++;
+        if (stamp_ == 0) {
+            std::fill(slots_.begin(), slots_.end(), Slot());
+            stamp_ = 1;
+        }
+        size_ = 0;
+    }
+
+    /**
+     * @brief Adds the state with the given value unless it is already in
+     * the table.
+     *
+     * @param s State.
+     * @param hash Hash of the state, as carried by its node.
+     * @param value Value of the state.
+     * @return True if the state was added.
+     */
+    bool emplace(const State &s, std::size_t hash, const V &value) {
+        if (2 * (size_ + 1) > slots_.size()) {
+            grow();
+        }
+        Slot &slot = slots_[find_slot(s, hash)];
+        if (slot.stamp == stamp_) {
+            return false;
+        }
+        slot.s = s;
+        slot.hash = hash;
+        slot.value = value;
+        slot.stamp = stamp_;
+        size_++;
+        return true;
+    }
+
+    /**
+     * @brief Finds the value of the state with the given hash.
+     *
+     * @return Value of the state, or nullptr if it is not in the table.
+     */
+    const V *find(const State &s, std::size_t hash) const {
+        const Slot &slot = slots_[find_slot(s, hash)];
+        return (slot.stamp == stamp_) ? &slot.value : nullptr;
+    }
+
+private:
+    /** @brief initial number of slots, a power of two */
+    static const std::size_t MIN_CAPACITY = 1024;
+
+    /**
+     * @brief Table slot.
+     */
+    struct Slot {
+        State s;
+        std::size_t hash;
+        V value;
+        /** @brief stamp of the entry, or 0 */
+        uint32_t stamp;
+
+        /**
+         * @brief Constructor.
+         */
+        Slot()
+            : s(), hash(0), value(), stamp(0)
+        {}
+    };
+
+    /**
+     * @brief Gets the slot of the state, or the free slot where it belongs.
+     */
+    std::size_t find_slot(const State &s, std::size_t hash) const {
+        std::size_t mask = slots_.size() - 1;
+        for (std::size_t i = hash & mask; ; i = (i + 1) & mask) {
+            const Slot &slot = slots_[i];
+            if (slot.stamp != stamp_ || (slot.hash == hash && slot.s == s)) {
+                return i;
+            }
+        }
+    }
+
+    /**
+     * @brief Doubles the number of slots and moves the current entries.
+     */
+    void grow() {
+        ArenaVector<Slot> old_slots(2 * slots_.size());
+        old_slots.swap(slots_);
+        for (const Slot &slot : old_slots) {
+            if (slot.stamp == stamp_) {
+                slots_[find_slot(slot.s, slot.hash)] = slot;
+            }
+        }
+    }
+
+    ArenaVector<Slot> slots_;
+    std::size_t size_;
+    /** @brief stamp of the current entries */
+    uint32_t stamp_;
+};
+
+/**
+ * @brief Cheapest solution found by any thread of a parallel search, and the
+ * flag that stops them all.
+ */
+class Incumbent {
+public:
+    /**
+     * @brief Constructor.
+     */
+    Incumbent()
+        : cost_(INT_MAX), stop_(false)
+    {}
+
+    /**
+     * @brief Clears the incumbent for a new solve.
+     */
+    void reset() {
+        cost_ = INT_MAX;
+        stop_ = false;
+    }
+
+    /**
+     * @brief Gets the cost of the cheapest solution so far, or INT_MAX.
+     */
+    int get() const {
+        return cost_.load();
+    }
+
+    /**
+     * @brief Lowers the cost to the given one if it is cheaper.
+     *
+     * @return Cost of the cheapest solution so far.
+     */
+    int improve(int cost) {
+        int current = cost_.load();
+        while (cost < current && !cost_.compare_exchange_weak(current, cost)) {
+        }
+        return std::min(cost, current);
+    }
+
+    /**
+     * @brief Tells every thread to stop.
+     */
+    void stop() {
+        stop_ = true;
+    }
+
+    /**
+     * @brief Checks if any thread has asked to stop.
+     */
+    bool is_stopped() const {
+        return stop_.load();
+    }
+
+private:
+    std::atomic<int> cost_;
+    std::atomic<bool> stop_;
+};
@@ -0,0 +1,336 @@
+/**
+ * @file check_search.cpp
+ * @brief Checks the costs found by every algorithm against exact distances
+ * and the incremental node updates against values computed from scratch.
+ *
+ * Every algorithm and mode that main can run takes part: GBFHS with one
+ * thread, with NUM_THREADS threads and concurrently, MMe serially and
+ * concurrently, A*, HDA* with NUM_THREADS threads and IDA* with and without
+ * a transposition table.
+ *
+ * - On random 8-pancake stacks, with GAP-x for x in {0, 2, 5}, every cost
+ *   must equal the distance found by a breadth-first search over all 8!
+ *   stacks.
+ * - On 15- and 24-puzzle instances made by random walks from the goal, every
+ *   cost must equal that of A*, be at most the length of the walk and have
+ *   its parity. The 15-puzzle instances are solved with Manhattan distance
+ *   and with pattern databases.
+ * - Along random walks on the 3x3, 4x4 and 5x5 boards, the hash, heuristic
+ *   values and tile squares that expand() and make_move() derive must equal
+ *   those that make_root() computes from scratch, and unmake_move() must
+ *   restore the node.
+ *
+ * Prints every failed check and exits with status 1 if there was one.
+ *
+ * Usage: make check_search && ./check_search [instances]
+ *
+ * @author Andrew Gu (andrewg2)
+ * @bug No known bugs.
+ */
+
+#include "gbfhs.h"
+#include "mme.h"
+#include "astar.h"
+#include "ida.h"
+#include "puzzle.h"
+#include "pancake.h"
+
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cstdlib>
+
+/** @brief default number of instances of each configuration */
+#define NUM_INSTANCES (100)
+
+/** @brief number of threads of the multi-threaded modes */
+#define NUM_THREADS (3)
+
+/** @brief log2 of the size of the IDA* transposition table */
+#define IDA_TABLE_BITS (16)
+
+/** @brief number of moves of the random walks */
+#define WALK_LENGTH (30)
+
+/** @brief number of failed checks */
+static int num_failures = 0;
+
+/**
+ * @brief Reports a check that failed.
+ *
+ * @param what Description of the check.
+ * @param expected Expected value.
+ * @param found Value found.
+ * @return Void.
+ */
+void fail(const std::string &what, int expected, int found) {
+    std::cout << "FAILED " << what << ": expected " << expected << ", found " << found << std::endl;
+    num_failures++;
+}
+
+/**
+ * @brief Solvers of every algorithm and mode that main can run.
+ */
+template <class Store>
+struct AllSolvers {
+    typedef typename Store::Domain P;
+    typedef typename Store::State State;
+
+    GbfhsSolver<Store> gbfhs;
+    GbfhsSolver<Store> gbfhs_threads;
+    GbfhsSolver<Store> gbfhs_concurrent;
+    MmeSolver<Store> mme;
+    MmeSolver<Store> mme_concurrent;
+    AStarSolver<Store> astar;
+    HdaStarSolver<Store> hdastar;
+    IdaStarSolver<P> ida;
+    IdaStarSolver<P> ida_table;
+
+    /**
+     * @brief Constructor.
+     */
+    AllSolvers(int eps, int discount, const HeuristicKinds &kinds)
+        : gbfhs(eps, discount, kinds), gbfhs_threads(eps, discount, kinds),
+          gbfhs_concurrent(eps, discount, kinds), mme(eps, discount, kinds),
+          mme_concurrent(eps, discount, kinds), astar(discount, kinds),
+          hdastar(discount, kinds, NUM_THREADS), ida(discount, kinds, 0),
+          ida_table(discount, kinds, IDA_TABLE_BITS)
+    {
+        gbfhs_threads.set_num_threads(NUM_THREADS);
+        gbfhs_concurrent.set_concurrent(true);
+        mme_concurrent.set_concurrent(true);
+    }
+
+    /**
+     * @brief Solves an instance with every solver.
+     *
+     * @param is Initial state.
+     * @param gs Goal state.
+     * @return Name and cost of every solver, A* first.
+     */
+    std::vector<std::pair<std::string, int>> solve(State is, State gs) {
+        return {
+            {"A*", astar.solve(is, gs)},
+            {"GBFHS", gbfhs.solve(is, gs)},
+            {"GBFHS -t", gbfhs_threads.solve(is, gs)},
+            {"GBFHS -c", gbfhs_concurrent.solve(is, gs)},
+            {"MMe", mme.solve(is, gs)},
+            {"MMe -c", mme_concurrent.solve(is, gs)},
+            {"HDA*", hdastar.solve(is, gs)},
+            {"IDA*", ida.solve(is, gs)},
+            {"IDA* -i", ida_table.solve(is, gs)},
+        };
+    }
+};
+
+/**
+ * @brief Hash of a state for the standard containers.
+ */
+template <class P>
+struct StateHash {
+    std::size_t operator()(const typename P::State &s) const {
+        return P::get_hash(s);
+    }
+};
+
+/**
+ * @brief Computes the distance of every state to the goal state by a
+ * breadth-first search from it. Moves must be their own inverses.
+ *
+ * @param gs Goal state.
+ * @param heuristic Heuristic that expand() derives successor values with.
+ * @return Distance of every state reachable from the goal state.
+ */
+template <class P>
+std::unordered_map<typename P::State, int, StateHash<P>> get_distances(typename P::State gs,
+                                                                      const typename P::Heuristic &heuristic) {
+    std::unordered_map<typename P::State, int, StateHash<P>> dist;
+    std::deque<typename P::Node> queue;
+    Counters counters;
+    dist[gs] = 0;
+    queue.push_back(P::make_root(gs, Direction::F, heuristic));
+    while (!queue.empty()) {
+        typename P::Node node = queue.front();
+        queue.pop_front();
+        int d = dist[node.s] + 1;
+        for (const typename P::Node &s_node : P::expand(node, heuristic, counters)) {
+            if (dist.emplace(s_node.s, d).second) {
+                queue.push_back(s_node);
+            }
+        }
+    }
+    return dist;
+}
+
+/**
+ * @brief Checks the costs of every solver on random stacks against the
+ * distances of a breadth-first search.
+ *
+ * @param num_instances Number of random stacks.
+ * @param gap_x x of the GAP-x heuristic.
+ * @return Void.
+ */
+template <int N>
+void check_pancakes(int num_instances, int gap_x) {
+    typedef Pancake<N> P;
+    HeuristicKinds kinds = {TileHeuristic::Manhattan, TileHeuristic::Manhattan};
+    std::vector<int> stack;
+    for (int i = 0; i < N; ++i) {
+        stack.push_back(i);
+    }
+    typename P::State gs = P::pack(stack);
+    typename P::Heuristic heuristic(gs, gs, gap_x, kinds);
+    auto dist = get_distances<P>(gs, heuristic);
+    AllSolvers<HashStore<P>> solvers(1, gap_x, kinds);
+    for (int i = 0; i < num_instances; ++i) {
+        std::random_shuffle(stack.begin(), stack.end());
+        typename P::State is = P::pack(stack);
+        solvers.gbfhs.seed(i);
+        for (const auto &result : solvers.solve(is, gs)) {
+            if (result.second != dist.at(is)) {
+                fail(P::get_name() + " x=" + std::to_string(gap_x) + " " + result.first, dist.at(is), result.second);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Checks that two n-puzzle nodes of the same state carry the same
+ * values.
+ *
+ * @param what Description of the check.
+ * @param node Node whose values were derived.
+ * @param expected Node whose values were computed from scratch.
+ * @return Void.
+ */
+template <class P>
+void check_node(const std::string &what, const typename P::Node &node, const typename P::Node &expected) {
+    if (node.s != expected.s || node.hash != expected.hash || node.pos != expected.pos || node.blank != expected.blank) {
+        fail(what + " state, hash and squares", 1, 0);
+    }
+    if (node.h_F != expected.h_F) {
+        fail(what + " h_F", expected.h_F, node.h_F);
+    }
+    if (node.h_B != expected.h_B) {
+        fail(what + " h_B", expected.h_B, node.h_B);
+    }
+}
+
+/**
+ * @brief Walks randomly from a node, checking the successors of every node
+ * on the way and every move made and unmade in place.
+ *
+ * @param node Node to start from.
+ * @param heuristic Heuristic of the search.
+ * @return Void.
+ */
+template <class P>
+void check_walk(typename P::Node node, const typename P::Heuristic &heuristic) {
+    std::string what = P::get_name() + ((node.dir == Direction::F) ? " forward" : " backward");
+    Counters counters;
+    for (int i = 0; i < WALK_LENGTH; ++i) {
+        typename P::NodeVector successors = P::expand(node, heuristic, counters);
+        for (const typename P::Node &s_node : successors) {
+            check_node<P>(what + " expand", s_node, P::make_root(s_node.s, node.dir, heuristic));
+        }
+        for (int k = 0; k < P::get_num_moves(node); ++k) {
+            typename P::Node moved = node;
+            typename P::Undo undo;
+            if (!P::make_move(moved, k, heuristic, undo)) {
+                continue;
+            }
+            check_node<P>(what + " make_move", moved, P::make_root(moved.s, node.dir, heuristic));
+            P::unmake_move(moved, undo);
+            check_node<P>(what + " unmake_move", moved, node);
+        }
+        node = successors[std::rand() % successors.size()];
+    }
+}
+
+/**
+ * @brief Checks the solvers on instances made by random walks from the goal
+ * state, and the node updates along further walks.
+ *
+ * @param num_instances Number of instances.
+ * @param kinds Kind of heuristic of each direction.
+ * @param solve Whether to run the solvers, or only check the walks.
+ * @return Void.
+ */
+template <int DIM>
+void check_puzzles(int num_instances, const HeuristicKinds &kinds, bool solve) {
+    typedef Puzzle<DIM> P;
+    int discount = 5;
+    std::vector<int> board;
+    for (int i = 0; i < P::SIZE; ++i) {
+        board.push_back(i);
+    }
+    typename P::State gs = P::pack(board);
+    P::Heuristic::prepare(gs, gs, kinds);
+    typename P::Heuristic walk_heuristic(gs, gs, discount, kinds);
+    AllSolvers<HashStore<P>> solvers(1, discount, kinds);
+    for (int i = 0; i < num_instances; ++i) {
+        /* instance at the end of a walk that undoes no move */
+        Counters counters;
+        typename P::Node node = P::make_root(gs, Direction::F, walk_heuristic);
+        for (int j = 0; j < WALK_LENGTH; ++j) {
+            typename P::NodeVector successors = P::expand(node, walk_heuristic, counters);
+            node = successors[std::rand() % successors.size()];
+        }
+        typename P::State is = node.s;
+
+        P::Heuristic::prepare(is, gs, kinds);
+        typename P::Heuristic heuristic(is, gs, discount, kinds);
+        check_walk<P>(P::make_root(is, Direction::F, heuristic), heuristic);
+        check_walk<P>(P::make_root(gs, Direction::B, heuristic), heuristic);
+        if (!solve) {
+            continue;
+        }
+        solvers.gbfhs.seed(i);
+        auto results = solvers.solve(is, gs);
+        int opt = results.front().second;
+        std::string what = P::get_name() + ((kinds[Direction::F] == TileHeuristic::AdditivePdb) ? " pdb " : " ");
+        if (opt > WALK_LENGTH || (WALK_LENGTH - opt) % 2 != 0) {
+            fail(what + "A* within the walk length and of its parity", WALK_LENGTH, opt);
+        }
+        for (const auto &result : results) {
+            if (result.second != opt) {
+                fail(what + result.first, opt, result.second);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Main function.
+ *
+ * Usage: ./check_search [instances]
+ *
+ * Runs every check on the given number of instances (default
+ * NUM_INSTANCES) of each configuration.
+ */
+int main(int argc, char **argv) {
+    int num_instances = (argc > 1) ? std::max(1, std::atoi(argv[1])) : NUM_INSTANCES;
+    HeuristicKinds manhattan = {TileHeuristic::Manhattan, TileHeuristic::Manhattan};
+    HeuristicKinds pdb = {TileHeuristic::AdditivePdb, TileHeuristic::AdditivePdb};
+    std::srand(15780);
+
+    for (int gap_x : {0, 2, 5}) {
+        check_pancakes<8>(num_instances, gap_x);
+    }
+    check_puzzles<3>(num_instances, manhattan, false);
+    check_puzzles<3>(num_instances, pdb, false);
+    check_puzzles<4>(num_instances, manhattan, true);
+    check_puzzles<4>(num_instances, pdb, true);
+    check_puzzles<5>(num_instances, manhattan, true);
+
+    if (num_failures > 0) {
+        std::cout << num_failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file counters.h
+ * @brief Struct definition for the counters reported by the search
+ * algorithms.
+ * 
+ * @author Andrew Gu (andrewg2)
+ * @bug No known bugs.
+ */
+
+#pragma once
+
+#include "arena.h"
+
+/**
+ * @brief Counters reported by the search algorithms.
+ */
+struct Counters {
+    /** @brief number of nodes expanded */
+    int nodes_expanded;
+    /** @brief number of successors skipped because they undo the move that
+     * generated their parent */
+    int moves_pruned;
+    /** @brief number of successors generated */
+    int nodes_generated;
+    /** @brief number of nodes pushed onto the open list (A* only) */
+    int nodes_pushed;
+    /** @brief number of popped nodes skipped because their state was already
+     * expanded or reached more cheaply (A* only) */
+    int stale_popped;
+    /** @brief number of nodes cut off because the transposition table holds
+     * their state at no greater cost (IDA* only) */
+    int transpositions;
+    /** @brief allocations of the per-solve arena */
+    ArenaStats arena;
+
+    /**
+     * @brief Constructor.
+     */
+    Counters()
+        : nodes_expanded(0), moves_pruned(0), nodes_generated(0),
+          nodes_pushed(0), stale_popped(0), transpositions(0)
+    {}
+
+    /**
+     * @brief Adds the search counts of another set of counters, such as
+     * those of a worker thread, leaving the arena statistics alone.
+     */
+    void add(const Counters &other) {
+        nodes_expanded += other.nodes_expanded;
+        moves_pruned += other.moves_pruned;
+        nodes_generated += other.nodes_generated;
+        nodes_pushed += other.nodes_pushed;
+        stale_popped += other.stale_popped;
+        transpositions += other.transpositions;
+    }
+};
@@ -0,0 +1,111 @@
+/**
+ * @file domain.h
+ * @brief Interface shared by the search domains.
+ *
+ * The stores and the search algorithms are templates over a domain P, which
+ * is resolved at compile time, so the hot loops call the domain's functions
+ * directly. A domain is a struct with the following members:
+ *
+ *     State           packed state, trivially copyable and comparable with ==
+ *     Node            node with the members s, hash, move, dir, h_F, h_B and
+ *                     get_h(dir)
+ *     NodeVector      ArenaVector<Node>
+ *     Heuristic       heuristic in both directions, built once per solve as
+ *                     Heuristic(initial, goal, discount, kinds) and
+ *                     evaluated from scratch as heuristic(s, dir), after
+ *                     Heuristic::prepare(initial, goal, kinds) has built
+ *                     the tables it shares between solves
+ *     SIZE            length of the vectors taken by pack()
+ *     NO_MOVE         move of a node that was not generated by a move
+ *     MAX_MOVES       largest number of moves of a node
+ *     Undo            values that unmake_move() restores
+ *
+ *     get_name()                 name used in experiment file names
+ *     pack(v)                    packs a permutation of [0, SIZE)
+ *     print_state(s)             prints a state
+ *     is_solved(s, g)            checks if s is the goal state g
+ *     is_solvable(s, g)          checks if g is reachable from s
+ *     get_hash(s)                hash of a state, as carried by its nodes
+ *     make_root(s, dir, heuristic)
+ *                                node of a state that no move generated
+ *     get_aux(node), make_node(s, hash, aux, move, dir, h_F, h_B)
+ *                                split a node into the byte-sized values that
+ *                                stores and queues keep, and rebuild it
+ *     expand(node, heuristic, counters)
+ *                                successors of a node, with their hashes and
+ *                                heuristic values derived from the node's
+ *     get_num_moves(node), make_move(node, k, heuristic, undo),
+ *     unmake_move(node, undo)    moves a node in place and back, for
+ *                                depth-first search without allocation;
+ *                                make_move() refuses the move that undoes
+ *                                the node's own
+ *
+ * Moves and heuristic values must fit in a byte. puzzle.h implements the
+ * n-puzzle and pancake.h the pancake problem.
+ *
+ * @author Andrew Gu (andrewg2)
+ * @bug No known bugs.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Forward or backward direction.
+ */
+enum Direction { F, B };
+
+/**
+ * @brief Kind of heuristic of the n-puzzle. Domains with a single heuristic
+ * ignore it.
+ */
+enum TileHeuristic { Manhattan, AdditivePdb };
+
+/** @brief kind of heuristic of each direction, indexed by Direction */
+typedef std::array<TileHeuristic, 2> HeuristicKinds;
+
+/**
+ * @brief Key of the maps that index nodes by state: a state together with
+ * the hash its node carries, so that no state is rehashed.
+ */
+template <class State>
+struct StateKey {
+    State s;
+    std::size_t hash;
+
+    /**
+     * @brief Compares the states only, since equal states have equal
+     * hashes.
+     */
+    bool operator==(const StateKey &other) const {
+        return s == other.s;
+    }
+};
+
+/**
+ * @brief Hash function of StateKey, which returns the carried hash.
+ */
+template <class State>
+struct StateKeyHash {
+    std::size_t operator()(const StateKey<State> &key) const {
+        return key.hash;
+    }
+};
+
+/**
+ * @brief Advances a splitmix64 generator and returns its next output.
+ * 
+ * Used to fill the Zobrist tables of the domains at compile time.
+ * 
+ * @param x (in/out) Generator state.
+ * @return Pseudorandom 64-bit value.
+ */
+constexpr uint64_t splitmix64(uint64_t &x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
@@ -1,41 +1,34 @@
 /**
  * @file gbfhs.cpp
- * @brief GBFHS implementation for n-puzzle problem.
+ * @brief GBFHS implementation, generic over the search domain.
  * 
  * @author Andrew Gu (andrewg2)
  * @bug No known bugs.
  */
 
 #include "gbfhs.h"
+#include "puzzle.h"
+#include "pancake.h"
 
-#include <random>
 #include <limits.h>
 #include <assert.h>
 
-/* used for randomness */
-std::random_device rd;
-std::mt19937 gen(rd());
-
 /**
  * @brief Checks if the given node is expandable in the given direction.
  * 
  * A node is expandable iff f_D(node) <= fLim and g_D(node) < gLim_D.
  * 
  * @param node Node to check.
+ * @param g_D_ Cost of the node in the given direction.
  * @param dir Direction to check.
- * @param is Initial state.
- * @param gs Goal state.
- * @param discount Used for degrading the heuristic.
  * @param fLim Lower bound on the optimal solution cost.
  * @param gLim_D Upper bound on the g-value of nodes to explore in direction D.
- * @param g_D Map from nodes to costs.
  * @return True if the node is expandable; false otherwise.
  */
-bool is_expandable(const Node &node, Direction dir, const std::vector<int> &is, const std::vector<int> &gs, int discount, int fLim, int gLim_D, const NodeIntMap &g_D) {
+template <class Node>
+bool is_expandable(const Node &node, int g_D_, Direction dir, int fLim, int gLim_D) {
     assert(dir == Direction::F || dir == Direction::B);
-    int g_D_ = g_D.find(node)->second;
-    int h_D = (dir == Direction::F) ? h(node.s, gs, discount) : h(node.s, is, discount);
-    int f_D = g_D_ + h_D;
+    int f_D = g_D_ + node.get_h(dir);
     return f_D <= fLim && g_D_ < gLim_D;
 }
 
@@ -86,19 +79,96 @@ void split(int gLSum, int &gLim_F, int &gLim_B) {
  * 
  * @param expandable_F Subset of open_F that is forward expandable.
  * @param expandable_B Subset of open_B that is backward expandable.
- * @return Uniform random node chosen from the two expandable sets.
+ * @param gen Generator to draw from.
+ * @param dir (output) Direction of the set holding the chosen node.
+ * @return Index of the chosen node in the expandable set of direction dir.
  */
-Node pick(const NodeSet &expandable_F, const NodeSet &expandable_B) {
-    std::uniform_int_distribution<> dist(0, expandable_F.size() + expandable_B.size() - 1);
-    int random_index = dist(gen);
-    auto it = expandable_F.begin();
-    if (random_index >= static_cast<int>(expandable_F.size())) {
-        random_index -= expandable_F.size();    
-        it = expandable_B.begin();
+template <class P>
+std::size_t pick(const ExpandableSet<P> &expandable_F, const ExpandableSet<P> &expandable_B, std::mt19937 &gen, Direction &dir) {
+    std::uniform_int_distribution<std::size_t> dist(0, expandable_F.size() + expandable_B.size() - 1);
+    std::size_t random_index = dist(gen);
+    if (random_index < expandable_F.size()) {
+        dir = Direction::F;
+        return random_index;
     }
-    assert(random_index >= 0);
-    std::advance(it, random_index);
-    return *it;   
+    dir = Direction::B;
+    return random_index - expandable_F.size();
+}
+
+/**
+ * @brief Constructor.
+ * 
+ * The generator of the random picks is seeded from std::random_device until
+ * seed() is called.
+ * 
+ * @param eps Integer representing the minimum-cost operator in the domain,
+ * i.e. the cheapest edge in the state space.
+ * @param discount Used for degrading the heuristic.
+ * @param kinds Kind of heuristic of each direction.
+ */
+template <class Store>
+GbfhsSolver<Store>::GbfhsSolver(int eps, int discount, const HeuristicKinds &kinds)
+    : eps_(eps), discount_(discount), kinds_(kinds), gen_(std::random_device()()), arena_(counters_.arena),
+      store_(arena_.make<Store>()),
+      expandable_F_(arena_.make<ExpandableSet<P>>()),
+      expandable_B_(arena_.make<ExpandableSet<P>>()),
+      pool_(new WorkStealingPool(1)),
+      batch_(arena_.make<ArenaVector<Successor>>()),
+      concurrent_(false)
+{}
+
+/**
+ * @brief Sets the number of threads that expand each level, and turns the
+ * concurrent mode off.
+ * 
+ * One thread (the default) expands nodes one at a time in random order;
+ * more threads expand each level in batches.
+ * 
+ * @param num_threads Number of threads, or 0 for one per hardware thread.
+ * @return Void.
+ */
+template <class Store>
+void GbfhsSolver<Store>::set_num_threads(int num_threads) {
+    concurrent_ = false;
+    pool_.reset(new WorkStealingPool(num_threads));
+    workers_.clear();
+    for (int w = 0; w < pool_->get_num_threads(); ++w) {
+        workers_.emplace_back(new Worker());
+    }
+}
+
+/**
+ * @brief Turns the concurrent mode on or off, replacing the number of
+ * threads given to set_num_threads().
+ * 
+ * In the concurrent mode, the pool has a worker for each direction: the
+ * calling thread for the forward direction and a thread that lives as long
+ * as the solver for the backward one. The picks draw on both directions at
+ * once, so which node comes next depends on what the previous expansion
+ * added, and only the expansions known at the start of a level can be
+ * made ahead of the picks. Those that a level never uses, such as the rest
+ * of the last level's frontier, are dropped uncounted.
+ * 
+ * @param concurrent True to give each direction a worker.
+ * @return Void.
+ */
+template <class Store>
+void GbfhsSolver<Store>::set_concurrent(bool concurrent) {
+    set_num_threads(concurrent ? 2 : 1);
+    concurrent_ = concurrent;
+}
+
+/**
+ * @brief Clears the store and the expandable sets, keeping their memory for
+ * the next solve.
+ * 
+ * @return Void.
+ */
+template <class Store>
+void GbfhsSolver<Store>::reset() {
+    store_.clear();
+    expandable_F_.clear();
+    expandable_B_.clear();
 }
 
 /**
@@ -110,85 +180,157 @@ Node pick(const NodeSet &expandable_F, const NodeSet &expandable_B) {
  * backward direction.
  * @param fLim Lower bound on the optimal solution cost.
  * @param best Lowest solution cost so far.
- * @param is Initial state.
- * @param gs Goal state.
- * @param discount Used for degrading the heuristic.
- * @param nodes_expanded Number of nodes expanded so far.
- * @param open_F Forward open set.
- * @param open_B Backward open set.
- * @param closed_F Forward closed set.
- * @param closed_B Backward closed set.
- * @param g_F Map from nodes to forward costs.
- * @param g_B Map from nodes to backward costs.
+ * @param heuristic Heuristic of the current solve.
  * @return Void.
  */
-void expand_level(int gLim_F, int gLim_B, int fLim, int &best, const std::vector<int> &is, const std::vector<int> &gs, int discount, int &nodes_expanded,
-    NodeSet &open_F, NodeSet &open_B, NodeSet &closed_F, NodeSet &closed_B, NodeIntMap &g_F, NodeIntMap &g_B) {
-    /* construct expandable sets */
-    NodeSet expandable_F;  // subset of open_F
-    NodeSet expandable_B;  // subset of open_B
-    for (const Node &node : open_F) {
-        if (is_expandable(node, Direction::F, is, gs, discount, fLim, gLim_F, g_F)) {
-            expandable_F.emplace(node);
-        }
-    }
-    for (const Node &node : open_B) {
-        if (is_expandable(node, Direction::B, is, gs, discount, fLim, gLim_B, g_B)) {
-            expandable_B.emplace(node);
-        }
+template <class Store>
+void GbfhsSolver<Store>::expand_level(int gLim_F, int gLim_B, int fLim, int &best, const typename P::Heuristic &heuristic) {
+    /* construct expandable sets from the open buckets below the limits */
+    expandable_F_.clear();
+    expandable_B_.clear();
+    store_.for_each_open(Direction::F, gLim_F, fLim, [&](const Node &node, int g_F) {
+        assert(is_expandable(node, g_F, Direction::F, fLim, gLim_F));
+        expandable_F_.insert(node);
+    });
+    store_.for_each_open(Direction::B, gLim_B, fLim, [&](const Node &node, int g_B) {
+        assert(is_expandable(node, g_B, Direction::B, fLim, gLim_B));
+        expandable_B_.insert(node);
+    });
+    if (concurrent_) {
+        expandable_F_.tag_by_index();
+        expandable_B_.tag_by_index();
+        pool_->run(2, [&](std::size_t d, int worker) {
+            prefetch(static_cast<Direction>(d), worker, heuristic);
+        });
+    } else if (pool_->get_num_threads() > 1) {
+        expand_level_batched(gLim_F, gLim_B, fLim, best, heuristic);
+        return;
     }
 
     /* main loop */
-    while (!expandable_F.empty() || !expandable_B.empty()) {
-        Node node = pick(expandable_F, expandable_B);
-        Direction dir = node.dir;
+    while (!expandable_F_.empty() || !expandable_B_.empty()) {
+        Direction dir;
+        std::size_t index = pick(expandable_F_, expandable_B_, gen_, dir);
         
         /* generalize to D == F or D == B */
-        NodeSet &open_D = (dir == Direction::F) ? open_F : open_B;
-        NodeSet &open_D_opp = (dir == Direction::F) ? open_B : open_F;
-        NodeSet &closed_D = (dir == Direction::F) ? closed_F : closed_B;
-        NodeSet &expandable_D = (dir == Direction::F) ? expandable_F : expandable_B;
-        NodeIntMap &g_D = (dir == Direction::F) ? g_F : g_B;
-        NodeIntMap &g_D_opp = (dir == Direction::F) ? g_B : g_F;
+        ExpandableSet<P> &expandable_D = (dir == Direction::F) ? expandable_F_ : expandable_B_;
         int gLim_D = (dir == Direction::F) ? gLim_F : gLim_B;
 
-        /* mark node as closed */
-        assert(closed_D.count(node) == 0);
-        expandable_D.erase(node);
-        open_D.erase(node);
-        closed_D.insert(node);
+        /* mark node as closed; it is expanded in place before erase() moves
+         * the last node over it */
+        const Node &node = expandable_D[index];
+        assert(node.dir == dir);
+        Handle node_h = store_.find(node.s, node.hash);
+        assert(!store_.is_closed(node_h, dir));
+        store_.close(node_h, dir);
 
-        /* iterate over successor nodes */
-        NodeVector successors = expand(node, nodes_expanded);
-        for (Node &s_node : successors) {
-            /* continue if node visits s_node via a suboptimal path */
-            bool already_seen = open_D.count(s_node) > 0 || closed_D.count(s_node) > 0;
-            if (already_seen) {
-                assert(g_D.count(node) > 0 && g_D.count(s_node) > 0);
-                bool suboptimal_cost = g_D[node] + 1 >= g_D[s_node];  // assumes unit cost
-                if (suboptimal_cost) {
-                    continue;
-                }
+        /* iterate over successor nodes, taking those of a tagged node from
+         * the buffer of its direction */
+        int g_D_node = store_.get_g(node_h, dir);
+        std::size_t tag = expandable_D.get_tag(index);
+        typename P::NodeVector successors;
+        const Node *first;
+        const Node *last;
+        if (tag == ExpandableSet<P>::NO_TAG) {
+            successors = P::expand(node, heuristic, counters_);
+            first = successors.data();
+            last = first + successors.size();
+        } else {
+            const Prefetch &prefetch = prefetched_[dir];
+            first = prefetch.successors.data() + ((tag > 0) ? prefetch.expansions[tag - 1].end : 0);
+            last = prefetch.successors.data() + prefetch.expansions[tag].end;
+            counters_.add(prefetch.expansions[tag].counters);
+        }
+        expandable_D.erase(index);
+        for (const Node *s_node = first; s_node != last; ++s_node) {
+            if (visit(*s_node, g_D_node + 1, gLim_D, fLim, best)) {  // assumes unit cost
+                return;
             }
+        }
+    }
+}
 
-            /* node visits s_node via a cheaper path */
-            open_D.erase(s_node);
-            closed_D.erase(s_node);
+/**
+ * @brief Expands every node of one direction's expandable set into the
+ * buffer of the direction, in the order of their tags.
+ * 
+ * Only reads the expandable set, which the level leaves alone until both
+ * directions are done.
+ * 
+ * @param dir Direction to expand.
+ * @param worker Index of the worker running the direction.
+ * @param heuristic Heuristic of the current solve.
+ * @return Void.
+ */
+template <class Store>
+void GbfhsSolver<Store>::prefetch(Direction dir, int worker, const typename P::Heuristic &heuristic) {
+    Arena::Scope scope(workers_[worker]->arena);
+    const ExpandableSet<P> &expandable_D = (dir == Direction::F) ? expandable_F_ : expandable_B_;
+    Prefetch &prefetch = prefetched_[dir];
+    prefetch.successors.clear();
+    prefetch.expansions.resize(expandable_D.size());
+    for (std::size_t i = 0; i < expandable_D.size(); ++i) {
+        assert(expandable_D.get_tag(i) == i);
+        Expansion &expansion = prefetch.expansions[i];
+        expansion.counters = Counters();
+        typename P::NodeVector successors = P::expand(expandable_D[i], heuristic, expansion.counters);
+        prefetch.successors.insert(prefetch.successors.end(), successors.begin(), successors.end());
+        expansion.end = prefetch.successors.size();
+    }
+}
 
-            if (g_D.count(s_node) > 0) {
-                assert(g_D[s_node] > g_D[node] + 1);
-            }
-            g_D[s_node] = g_D[node] + 1;  // assumes unit cost
-            open_D.insert(s_node);
-            if (is_expandable(s_node, dir, is, gs, discount, fLim, gLim_D, g_D)) {
-                expandable_D.insert(s_node);
+/**
+ * @brief Expands the current level in batches on the solver's threads.
+ * 
+ * Each batch closes every expandable node, which the workers then expand in
+ * chunks. Nodes reached more cheaply by a later node of the same batch are
+ * reopened by the merge and expanded again in a later batch, as they would
+ * be by the serial loop.
+ * 
+ * @param gLim_F Upper bound on the g-value of nodes to explore in the forward
+ * direction.
+ * @param gLim_B Upper bound on the g-value of nodes to explore in the
+ * backward direction.
+ * @param fLim Lower bound on the optimal solution cost.
+ * @param best Lowest solution cost so far.
+ * @param heuristic Heuristic of the current solve.
+ * @return Void.
+ */
+template <class Store>
+void GbfhsSolver<Store>::expand_level_batched(int gLim_F, int gLim_B, int fLim, int &best, const typename P::Heuristic &heuristic) {
+    while (!expandable_F_.empty() || !expandable_B_.empty()) {
+        /* close the whole frontier */
+        batch_.clear();
+        for (int d = Direction::F; d <= Direction::B; ++d) {
+            Direction dir = static_cast<Direction>(d);
+            ExpandableSet<P> &expandable_D = (dir == Direction::F) ? expandable_F_ : expandable_B_;
+            for (std::size_t i = 0; i < expandable_D.size(); ++i) {
+                const Node &node = expandable_D[i];
+                assert(node.dir == dir);
+                Handle node_h = store_.find(node.s, node.hash);
+                assert(!store_.is_closed(node_h, dir));
+                store_.close(node_h, dir);
+                batch_.push_back(Successor{node, store_.get_g(node_h, dir)});
             }
+            expandable_D.clear();
+        }
+
+        /* expand it in parallel; the store is only read until the merge */
+        std::size_t num_chunks = (batch_.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        if (chunks_.size() < num_chunks) {
+            chunks_.resize(num_chunks);
+        }
+        pool_->run(num_chunks, [&](std::size_t c, int worker) {
+            expand_chunk(c, worker, heuristic);
+        });
 
-            /* check for collision */
-            if (open_D_opp.count(s_node) > 0) {
-                assert(g_D.count(s_node) > 0 && g_D_opp.count(s_node) > 0);
-                best = std::min(best, g_D[s_node] + g_D_opp[s_node]);
-                if (best <= fLim) {
+        /* merge the successors in chunk order */
+        for (std::size_t c = 0; c < num_chunks; ++c) {
+            counters_.add(chunks_[c].counters);
+            for (const Successor &successor : chunks_[c].successors) {
+                Direction dir = successor.node.dir;
+                int gLim_D = (dir == Direction::F) ? gLim_F : gLim_B;
+                if (visit(successor.node, successor.g, gLim_D, fLim, best)) {
                     return;
                 }
             }
@@ -196,53 +338,186 @@ void expand_level(int gLim_F, int gLim_B, int fLim, int &best, const std::vector
     }
 }
 
+/**
+ * @brief Expands one chunk of the current batch into the chunk's buffer.
+ * 
+ * Successors that the store already holds at no greater cost in their
+ * direction are dropped here, so the merge only sees candidates. The merge
+ * checks them again, since the batch may reach a state more than once.
+ * 
+ * @param c Index of the chunk.
+ * @param worker Index of the worker running the chunk.
+ * @param heuristic Heuristic of the current solve.
+ * @return Void.
+ */
+template <class Store>
+void GbfhsSolver<Store>::expand_chunk(std::size_t c, int worker, const typename P::Heuristic &heuristic) {
+    Arena::Scope scope(workers_[worker]->arena);
+    Chunk &chunk = chunks_[c];
+    chunk.successors.clear();
+    chunk.counters = Counters();
+    std::size_t end = std::min(batch_.size(), (c + 1) * CHUNK_SIZE);
+    for (std::size_t i = c * CHUNK_SIZE; i < end; ++i) {
+        const Successor &parent = batch_[i];
+        Direction dir = parent.node.dir;
+        int g = parent.g + 1;  // assumes unit cost
+        typename P::NodeVector successors = P::expand(parent.node, heuristic, chunk.counters);
+        for (Node &s_node : successors) {
+            Handle s_node_h = store_.find(s_node.s, s_node.hash);
+            if (s_node_h != NOT_FOUND && store_.has_g(s_node_h, dir) && store_.get_g(s_node_h, dir) <= g) {
+                continue;
+            }
+            chunk.successors.push_back(Successor{s_node, g});
+        }
+    }
+}
+
+/**
+ * @brief Records a successor in the store and checks it for a collision.
+ * 
+ * The successor is skipped if its state was already seen at no greater
+ * cost in its direction. Otherwise it is opened with the given cost, added
+ * to the expandable set if it is expandable, and checked against the
+ * opposite direction. Batches close a whole frontier before any of its
+ * successors are merged, so two adjacent nodes of a batch never see each
+ * other open; batched levels therefore also count collisions with states
+ * closed in the opposite direction, which are paths all the same.
+ * 
+ * @param s_node Successor node.
+ * @param g Cost of the successor in its direction.
+ * @param gLim_D Upper bound on the g-value of nodes to explore in the
+ * direction of the successor.
+ * @param fLim Lower bound on the optimal solution cost.
+ * @param best Lowest solution cost so far.
+ * @return True if best <= fLim, which ends the level; false otherwise.
+ */
+template <class Store>
+bool GbfhsSolver<Store>::visit(const Node &s_node, int g, int gLim_D, int fLim, int &best) {
+    Direction dir = s_node.dir;
+    Direction opp = (dir == Direction::F) ? Direction::B : Direction::F;
+    Handle s_node_h = store_.insert(s_node.s, s_node.hash);
+
+    /* skip s_node if it is reached via a suboptimal path */
+    bool already_seen = store_.is_open(s_node_h, dir) || store_.is_closed(s_node_h, dir);
+    if (already_seen) {
+        assert(store_.has_g(s_node_h, dir));
+        bool suboptimal_cost = g >= store_.get_g(s_node_h, dir);
+        if (suboptimal_cost) {
+            return false;
+        }
+    }
+
+    /* s_node is reached via a cheaper path */
+    if (store_.has_g(s_node_h, dir)) {
+        assert(store_.get_g(s_node_h, dir) > g);
+    }
+    store_.set_g(s_node_h, dir, g);
+    store_.open(s_node_h, s_node, dir);
+    if (is_expandable(s_node, g, dir, fLim, gLim_D)) {
+        /* replace any copy that still records the old parent's move */
+        ExpandableSet<P> &expandable_D = (dir == Direction::F) ? expandable_F_ : expandable_B_;
+        expandable_D.insert(s_node);
+    }
+
+    /* check for collision */
+    bool batched = !concurrent_ && pool_->get_num_threads() > 1;
+    if (store_.is_open(s_node_h, opp) || (batched && store_.is_closed(s_node_h, opp))) {
+        assert(store_.has_g(s_node_h, opp));
+        best = std::min(best, g + store_.get_g(s_node_h, opp));
+        if (best <= fLim) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
  * @brief Runs the GBFHS algorithm with the given initial and goal states.
  * 
  * @param initial_state Initial state.
  * @param goal_state Goal state.
- * @param eps Integer representing the minimum-cost operator in the domain,
- * i.e. the cheapest edge in the state space.
- * @param discount Used for degrading the heuristic.
- * @param nodes_expanded To be set to the number of nodes expanded.
  * @return Optimal cost.
  */
-int gbfhs(const std::vector<int> &initial_state, const std::vector<int> &goal_state, int eps, int discount, int &nodes_expanded) {
-    if (is_solved(initial_state, goal_state)) {
+template <class Store>
+int GbfhsSolver<Store>::solve(State initial_state, State goal_state) {
+    counters_ = Counters();
+    if (P::is_solved(initial_state, goal_state)) {
         return 0;
     }
     int best = INT_MAX;  // unsolvable
-    nodes_expanded = 0;
 
-    /* initialize node sets */
-    NodeSet open_F, open_B, closed_F, closed_B;
-    open_F.emplace(initial_state, Direction::F);
-    open_B.emplace(goal_state, Direction::B);
+    /* containers built during the solve take their memory from the arena */
+    Arena::Scope scope(arena_);
+    reset();
+
+    /* the only heuristic values computed from scratch are the roots' */
+    typename P::Heuristic heuristic(initial_state, goal_state, discount_, kinds_);
 
-    /* initialize cost data structures */
-    NodeIntMap g_F, g_B;
-    g_F.emplace(std::make_pair(Node { initial_state, Direction::F }, 0));
-    g_B.emplace(std::make_pair(Node { goal_state, Direction::B }, 0));    
+    /* initialize node sets and costs */
+    Node initial_node = P::make_root(initial_state, Direction::F, heuristic);
+    Node goal_node = P::make_root(goal_state, Direction::B, heuristic);
+    Handle initial_h = store_.insert(initial_state, initial_node.hash);
+    store_.set_g(initial_h, Direction::F, 0);
+    store_.open(initial_h, initial_node, Direction::F);
+    Handle goal_h = store_.insert(goal_state, goal_node.hash);
+    store_.set_g(goal_h, Direction::B, 0);
+    store_.open(goal_h, goal_node, Direction::B);
 
     /* initialize limits */
-    int fLim = std::max(std::max(h(initial_state, goal_state, discount), h(goal_state, initial_state, discount)), eps);
+    int fLim = std::max(std::max(initial_node.h_F, goal_node.h_B), eps_);
     int gLim_F = 0;
     int gLim_B = 0;
 
     /* main loop */
-    while (!open_F.empty() && !open_B.empty()) {
+    while (!store_.open_empty(Direction::F) && !store_.open_empty(Direction::B)) {
         if (best == fLim) {
             return best;
         }
-        int gLSum = fLim - eps + 1;
+        int gLSum = fLim - eps_ + 1;
         split(gLSum, gLim_F, gLim_B);
-        expand_level(gLim_F, gLim_B, fLim, best, initial_state, goal_state, discount, nodes_expanded, open_F, open_B, closed_F, closed_B, g_F, g_B);
+        expand_level(gLim_F, gLim_B, fLim, best, heuristic);
         if (best == fLim) {
             return best;
         }
-        // std::cout << "nodes expanded: " << nodes_expanded << std::endl;
+        // std::cout << "nodes expanded: " << counters_.nodes_expanded << std::endl;
         fLim++;
     }
     return best;
 }
 
+/**
+ * @brief Runs the GBFHS algorithm with the given initial and goal states on
+ * a solver of its own.
+ * 
+ * @param initial_state Initial state.
+ * @param goal_state Goal state.
+ * @param eps Integer representing the minimum-cost operator in the domain,
+ * i.e. the cheapest edge in the state space.
+ * @param discount Used for degrading the heuristic.
+ * @param kinds Kind of heuristic of each direction.
+ * @param counters To be set to the counters of the search.
+ * @return Optimal cost.
+ */
+template <class Store>
+int gbfhs(typename Store::State initial_state, typename Store::State goal_state, int eps, int discount, const HeuristicKinds &kinds, Counters &counters) {
+    GbfhsSolver<Store> solver(eps, discount, kinds);
+    int cost = solver.solve(initial_state, goal_state);
+    counters = solver.get_counters();
+    return cost;
+}
+
+/* explicit instantiations */
+template class GbfhsSolver<HashStore<Puzzle<3>>>;
+template class GbfhsSolver<HashStore<Puzzle<4>>>;
+template class GbfhsSolver<HashStore<Puzzle<5>>>;
+template class GbfhsSolver<DenseStore<Puzzle<3>>>;
+template class GbfhsSolver<HashStore<Pancake<8>>>;
+template class GbfhsSolver<HashStore<Pancake<12>>>;
+template class GbfhsSolver<HashStore<Pancake<16>>>;
+template int gbfhs<HashStore<Puzzle<3>>>(Puzzle<3>::State, Puzzle<3>::State, int, int, const HeuristicKinds &, Counters &);
+template int gbfhs<HashStore<Puzzle<4>>>(Puzzle<4>::State, Puzzle<4>::State, int, int, const HeuristicKinds &, Counters &);
+template int gbfhs<HashStore<Puzzle<5>>>(Puzzle<5>::State, Puzzle<5>::State, int, int, const HeuristicKinds &, Counters &);
+template int gbfhs<DenseStore<Puzzle<3>>>(Puzzle<3>::State, Puzzle<3>::State, int, int, const HeuristicKinds &, Counters &);
+template int gbfhs<HashStore<Pancake<8>>>(Pancake<8>::State, Pancake<8>::State, int, int, const HeuristicKinds &, Counters &);
+template int gbfhs<HashStore<Pancake<12>>>(Pancake<12>::State, Pancake<12>::State, int, int, const HeuristicKinds &, Counters &);
+template int gbfhs<HashStore<Pancake<16>>>(Pancake<16>::State, Pancake<16>::State, int, int, const HeuristicKinds &, Counters &);
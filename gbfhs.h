@@ -1,6 +1,6 @@
 /**
  * @file gbfhs.h
- * @brief Function interface for GBFHS.
+ * @brief Solver and function interface for GBFHS.
  * 
  * @author Andrew Gu (andrewg2)
  * @bug No known bugs.
@@ -8,7 +8,253 @@
 
 #pragma once
 
-#include "puzzle.h"
+#include "domain.h"
+#include "store.h"
+#include "pool.h"
+
+#include <random>
+#include <vector>
+#include <memory>
+#include <assert.h>
+
+/**
+ * @brief Set of expandable nodes with constant-time random access.
+ * 
+ * Nodes are kept in a dense vector and removed by swapping the last node
+ * into their place, so any index in [0, size()) is a valid pick. An index
+ * map from state to position lets a node reached again through a cheaper
+ * parent replace its stale copy in place. The map is keyed by the state
+ * together with the hash its node carries, so no state is rehashed. Each
+ * node also carries a tag, which tag_by_index() sets to its index and
+ * inserting a node clears.
+ */
+template <class P>
+class ExpandableSet {
+public:
+    typedef typename P::State State;
+    typedef typename P::Node Node;
+
+    /** @brief tag of a node inserted since the last tag_by_index() */
+    static constexpr std::size_t NO_TAG = SIZE_MAX;
+
+    /**
+     * @brief Checks if the set is empty.
+     */
+    bool empty() const {
+        return nodes_.empty();
+    }
+
+    /**
+     * @brief Gets the number of nodes in the set.
+     */
+    std::size_t size() const {
+        return nodes_.size();
+    }
+
+    /**
+     * @brief Gets the node at the given index.
+     */
+    const Node &operator[](std::size_t i) const {
+        return nodes_[i];
+    }
+
+    /**
+     * @brief Gets the tag of the node at the given index.
+     */
+    std::size_t get_tag(std::size_t i) const {
+        return tags_[i];
+    }
+
+    /**
+     * @brief Adds the node, replacing any node with the same state.
+     */
+    void insert(const Node &node) {
+        auto result = index_.emplace(Key{node.s, node.hash}, nodes_.size());
+        if (result.second) {
+            nodes_.push_back(node);
+            tags_.push_back(NO_TAG);
+        } else {
+            nodes_[result.first->second] = node;
+            tags_[result.first->second] = NO_TAG;
+        }
+    }
+
+    /**
+     * @brief Tags every node with its current index.
+     */
+    void tag_by_index() {
+        for (std::size_t i = 0; i < tags_.size(); ++i) {
+            tags_[i] = i;
+        }
+    }
+
+    /**
+     * @brief Removes every node, keeping the storage allocated.
+     */
+    void clear() {
+        nodes_.clear();
+        tags_.clear();
+        index_.clear();
+    }
+
+    /**
+     * @brief Removes the node at the given index, moving the last node into
+     * its place.
+     */
+    void erase(std::size_t i) {
+        assert(i < nodes_.size());
+        index_.erase(Key{nodes_[i].s, nodes_[i].hash});
+        if (i + 1 != nodes_.size()) {
+            nodes_[i] = nodes_.back();
+            tags_[i] = tags_.back();
+            index_[Key{nodes_[i].s, nodes_[i].hash}] = i;
+        }
+        nodes_.pop_back();
+        tags_.pop_back();
+    }
+
+private:
+    typedef StateKey<State> Key;
+
+    ArenaVector<Node> nodes_;
+    ArenaVector<std::size_t> tags_;
+    ArenaMap<Key, std::size_t, StateKeyHash<State>> index_;
+};
+
+/**
+ * @brief Reusable GBFHS solver.
+ * 
+ * The store and the expandable sets live as long as the solver and take
+ * their memory from its arena. solve() clears them with reset(), which
+ * keeps the table, the open buckets and the sets allocated, so a batch of
+ * instances only pays for growth up to the largest one. Each solver draws
+ * its random picks from a generator of its own, so solvers on different
+ * threads do not share state and a solve is reproducible after seed().
+ * 
+ * With more than one thread (see set_num_threads()), each level is expanded
+ * in batches instead of by random picks: the whole expandable frontier is
+ * closed, split into chunks that the workers expand into buffers of their
+ * own while probing the store read-only for duplicates, and the surviving
+ * successors are merged into the store in chunk order. The result does not
+ * depend on the number of threads.
+ * 
+ * In the concurrent mode (see set_concurrent()), each direction has a
+ * worker of its own. At the start of each level, the two workers expand
+ * the nodes of their direction's expandable set into buffers, and the
+ * random picks then take the successors of those nodes from the buffers.
+ * The picks and the store are those of the serial loop, so the result is
+ * the same.
+ */
+template <class Store>
+class GbfhsSolver {
+public:
+    typedef typename Store::Domain P;
+    typedef typename Store::State State;
+    typedef typename P::Node Node;
+
+    GbfhsSolver(int eps, int discount, const HeuristicKinds &kinds);
+    int solve(State initial_state, State goal_state);
+    void reset();
+
+    /**
+     * @brief Gets the counters of the last solve.
+     */
+    const Counters &get_counters() const {
+        return counters_;
+    }
+
+    /**
+     * @brief Reseeds the generator of the random picks.
+     */
+    void seed(unsigned seed) {
+        gen_.seed(seed);
+    }
+
+    void set_num_threads(int num_threads);
+    void set_concurrent(bool concurrent);
+
+private:
+    /** @brief number of frontier nodes that a worker expands as one job */
+    static const std::size_t CHUNK_SIZE = 128;
+
+    /**
+     * @brief Node together with its g-value in the direction of the node.
+     */
+    struct Successor {
+        Node node;
+        int g;
+    };
+
+    /**
+     * @brief Successors generated from one chunk of a batch.
+     * 
+     * The buffer is filled by whichever worker takes the chunk, so it
+     * allocates from the general heap rather than from an arena.
+     */
+    struct Chunk {
+        std::vector<Successor> successors;
+        Counters counters;
+    };
+
+    /**
+     * @brief Arena of one worker, which recycles the successor vectors of
+     * its expansions. Its allocations are not reported.
+     */
+    struct Worker {
+        ArenaStats stats;
+        Arena arena;
+
+        Worker()
+            : arena(stats)
+        {}
+    };
+
+    /**
+     * @brief Expansion of one node into the buffer of its direction.
+     */
+    struct Expansion {
+        /** @brief end of the node's successors in the buffer; they begin
+         * where those of the previous node end */
+        std::size_t end;
+        /** @brief counters of the expansion, added when it is used */
+        Counters counters;
+    };
+
+    /**
+     * @brief Successors of the nodes that one direction's expandable set
+     * held at the start of the level, in the order of their tags.
+     * 
+     * The buffer is filled by whichever worker takes the direction, so it
+     * allocates from the general heap rather than from an arena.
+     */
+    struct Prefetch {
+        std::vector<Node> successors;
+        std::vector<Expansion> expansions;
+    };
+
+    void prefetch(Direction dir, int worker, const typename P::Heuristic &heuristic);
+    void expand_level(int gLim_F, int gLim_B, int fLim, int &best, const typename P::Heuristic &heuristic);
+    void expand_level_batched(int gLim_F, int gLim_B, int fLim, int &best, const typename P::Heuristic &heuristic);
+    void expand_chunk(std::size_t c, int worker, const typename P::Heuristic &heuristic);
+    bool visit(const Node &s_node, int g, int gLim_D, int fLim, int &best);
+
+    int eps_;
+    int discount_;
+    HeuristicKinds kinds_;
+    std::mt19937 gen_;
+    Counters counters_;
+    Arena arena_;
+    Store store_;
+    ExpandableSet<P> expandable_F_;  // subset of open_F
+    ExpandableSet<P> expandable_B_;  // subset of open_B
+    std::unique_ptr<WorkStealingPool> pool_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    ArenaVector<Successor> batch_;
+    std::vector<Chunk> chunks_;
+    bool concurrent_;
+    Prefetch prefetched_[2];
+};
 
 /* exported function prototypes */
-int gbfhs(const std::vector<int> &initial_state, const std::vector<int> &goal_state, int eps, int gap_x, int &nodes_expanded);
\ No newline at end of file
+template <class Store>
+int gbfhs(typename Store::State initial_state, typename Store::State goal_state, int eps, int discount, const HeuristicKinds &kinds, Counters &counters);
\ No newline at end of file
@@ -0,0 +1,161 @@
+/**
+ * @file ida.cpp
+ * @brief IDA* implementation, generic over the search domain.
+ *
+ * @author Andrew Gu (andrewg2)
+ * @bug No known bugs.
+ */
+
+#include "ida.h"
+#include "puzzle.h"
+#include "pancake.h"
+
+#include <algorithm>
+#include <limits.h>
+#include <assert.h>
+
+/**
+ * @brief Constructor.
+ *
+ * @param discount Used for degrading the heuristic.
+ * @param kinds Kind of heuristic of each direction.
+ * @param table_bits log2 of the number of transposition table entries, or 0
+ * for no table.
+ */
+template <class P>
+IdaStarSolver<P>::IdaStarSolver(int discount, const HeuristicKinds &kinds, int table_bits)
+    : discount_(discount), kinds_(kinds), table_((table_bits > 0) ? std::size_t(1) << table_bits : 0, Entry{State(), 0, 0}),
+      iteration_(0), heuristic_(nullptr), goal_state_()
+{}
+
+/**
+ * @brief Records that the node's state was reached with the given cost in
+ * the current iteration.
+ *
+ * The table is direct-mapped by hash and the newer entry always wins.
+ *
+ * @param node Node reached.
+ * @param g Cost of the node.
+ * @return False if the table holds the state at no greater cost in this
+ * iteration, so the node can be cut off; true otherwise.
+ */
+template <class P>
+bool IdaStarSolver<P>::record(const Node &node, int g) {
+    Entry &entry = table_[node.hash & (table_.size() - 1)];
+    if (entry.iteration == iteration_ && entry.s == node.s && entry.g <= g) {
+        return false;
+    }
+    entry.s = node.s;
+    entry.g = g;
+    entry.iteration = iteration_;
+    return true;
+}
+
+/**
+ * @brief Searches below the node depth-first, up to the given bound on f.
+ *
+ * @param node (in/out) Node to search below; it is moved and moved back in
+ * place.
+ * @param g Cost of the node.
+ * @param bound Largest f to expand in this iteration.
+ * @param next_bound (in/out) Smallest f above the bound seen so far.
+ * @return Cost of the solution found, or NOT_FOUND.
+ */
+template <class P>
+int IdaStarSolver<P>::search(Node &node, int g, int bound, int &next_bound) {
+    int f = g + node.h_F;
+    if (f > bound) {
+        next_bound = std::min(next_bound, f);
+        return NOT_FOUND;
+    }
+    if (P::is_solved(node.s, goal_state_)) {
+        return g;
+    }
+    if (!table_.empty() && !record(node, g)) {
+        counters_.transpositions++;
+        return NOT_FOUND;
+    }
+
+    counters_.nodes_expanded++;
+    int num_moves = P::get_num_moves(node);
+    for (int k = 0; k < num_moves; ++k) {
+        typename P::Undo undo;
+        if (!P::make_move(node, k, *heuristic_, undo)) {
+            counters_.moves_pruned++;
+            continue;
+        }
+        counters_.nodes_generated++;
+        int cost = search(node, g + 1, bound, next_bound);  // assumes unit cost
+        P::unmake_move(node, undo);
+        if (cost != NOT_FOUND) {
+            return cost;
+        }
+    }
+    return NOT_FOUND;
+}
+
+/**
+ * @brief Runs the IDA* algorithm with the given initial and goal state.
+ *
+ * @param initial_state Initial state.
+ * @param goal_state Goal state.
+ * @return Optimal cost, or INT_MAX if the goal is unreachable.
+ */
+template <class P>
+int IdaStarSolver<P>::solve(State initial_state, State goal_state) {
+    counters_ = Counters();
+    typename P::Heuristic heuristic(initial_state, goal_state, discount_, kinds_);
+    heuristic_ = &heuristic;
+    goal_state_ = goal_state;
+
+    Node node = P::make_root(initial_state, Direction::F, heuristic);
+    int bound = node.h_F;
+    while (bound != INT_MAX) {
+        iteration_++;
+        int next_bound = INT_MAX;
+        int cost = search(node, 0, bound, next_bound);
+        if (cost != NOT_FOUND) {
+            heuristic_ = nullptr;
+            return cost;
+        }
+        assert(next_bound > bound);
+        bound = next_bound;
+    }
+    heuristic_ = nullptr;
+    return INT_MAX;  // unsolvable
+}
+
+/**
+ * @brief Runs the IDA* algorithm with the given initial and goal state on a
+ * solver of its own.
+ *
+ * @param initial_state Initial state.
+ * @param goal_state Goal state.
+ * @param discount Used for degrading the heuristic.
+ * @param kinds Kind of heuristic of each direction.
+ * @param table_bits log2 of the number of transposition table entries, or 0
+ * for no table.
+ * @param counters To be set to the counters of the search.
+ * @return Optimal cost.
+ */
+template <class P>
+int idastar(typename P::State initial_state, typename P::State goal_state, int discount, const HeuristicKinds &kinds, int table_bits, Counters &counters) {
+    IdaStarSolver<P> solver(discount, kinds, table_bits);
+    int cost = solver.solve(initial_state, goal_state);
+    counters = solver.get_counters();
+    return cost;
+}
+
+/* explicit instantiations */
+template class IdaStarSolver<Puzzle<3>>;
+template class IdaStarSolver<Puzzle<4>>;
+template class IdaStarSolver<Puzzle<5>>;
+template class IdaStarSolver<Pancake<8>>;
+template class IdaStarSolver<Pancake<12>>;
+template class IdaStarSolver<Pancake<16>>;
+template int idastar<Puzzle<3>>(Puzzle<3>::State, Puzzle<3>::State, int, const HeuristicKinds &, int, Counters &);
+template int idastar<Puzzle<4>>(Puzzle<4>::State, Puzzle<4>::State, int, const HeuristicKinds &, int, Counters &);
+template int idastar<Puzzle<5>>(Puzzle<5>::State, Puzzle<5>::State, int, const HeuristicKinds &, int, Counters &);
+template int idastar<Pancake<8>>(Pancake<8>::State, Pancake<8>::State, int, const HeuristicKinds &, int, Counters &);
+template int idastar<Pancake<12>>(Pancake<12>::State, Pancake<12>::State, int, const HeuristicKinds &, int, Counters &);
+template int idastar<Pancake<16>>(Pancake<16>::State, Pancake<16>::State, int, const HeuristicKinds &, int, Counters &);
@@ -0,0 +1,76 @@
+/**
+ * @file ida.h
+ * @brief Solver and function interface for IDA*.
+ *
+ * @author Andrew Gu (andrewg2)
+ * @bug No known bugs.
+ */
+
+#pragma once
+
+#include "domain.h"
+#include "counters.h"
+
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief Reusable IDA* solver.
+ *
+ * Each iteration is a depth-first search bounded by f, which moves a single
+ * node in place with the domain's make_move() and unmake_move(), so memory
+ * does not grow with the search and nothing is allocated per node. The
+ * moves that undo a node's own move are refused by make_move(). An optional
+ * transposition table of fixed size records the lowest g at which each
+ * state was reached in the current iteration and cuts off states reached
+ * again at no lower cost; entries are stamped with their iteration, so the
+ * table is never cleared.
+ */
+template <class P>
+class IdaStarSolver {
+public:
+    typedef typename P::State State;
+    typedef typename P::Node Node;
+
+    IdaStarSolver(int discount, const HeuristicKinds &kinds, int table_bits);
+    int solve(State initial_state, State goal_state);
+
+    /**
+     * @brief Gets the counters of the last solve.
+     */
+    const Counters &get_counters() const {
+        return counters_;
+    }
+
+private:
+    /** @brief cost returned by search() when no goal is within the bound */
+    static const int NOT_FOUND = -1;
+
+    /**
+     * @brief Transposition table entry.
+     */
+    struct Entry {
+        /** @brief packed state */
+        State s;
+        /** @brief lowest g at which the state was reached */
+        uint16_t g;
+        /** @brief iteration that wrote the entry, or 0 */
+        uint32_t iteration;
+    };
+
+    int search(Node &node, int g, int bound, int &next_bound);
+    bool record(const Node &node, int g);
+
+    int discount_;
+    HeuristicKinds kinds_;
+    Counters counters_;
+    std::vector<Entry> table_;
+    uint32_t iteration_;
+    /* valid during solve() */
+    const typename P::Heuristic *heuristic_;
+    State goal_state_;
+};
+
+/* exported function prototypes */
+template <class P>
+int idastar(typename P::State initial_state, typename P::State goal_state, int discount, const HeuristicKinds &kinds, int table_bits, Counters &counters);
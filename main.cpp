@@ -1,7 +1,14 @@
 /**
  * @file main.cpp
  * @brief Main function for experiments.
- * 
+ *
+ * Every (instance, algorithm) pair is a job of a batch that a
+ * work-stealing pool spreads across its workers. Each worker keeps solvers
+ * of its own, the instances are drawn before the batch starts and the
+ * random picks of GBFHS are seeded by instance, so the results depend only
+ * on the seed; they are written out in instance order once the batch is
+ * done.
+ *
  * @author Andrew Gu (andrewg2)
  * @bug No known bugs.
  */
@@ -9,87 +16,381 @@
 #include "gbfhs.h"
 #include "mme.h"
 #include "astar.h"
+#include "ida.h"
+#include "puzzle.h"
+#include "pancake.h"
+#include "pool.h"
 
 #include <random>
 #include <algorithm>
 #include <assert.h>
 #include <fstream>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <sstream>
 
 /* number of iterations to average over */
 #define NUM_ITERS (50)
 
+/* largest log2 of the size of the IDA* transposition table */
+#define MAX_IDA_TABLE_BITS (30)
+
 /**
- * @brief Main function.
+ * @brief Algorithms run on every instance, in output order. IDA* only runs
+ * if it is enabled, and alone if the others are disabled.
  */
-int main() {
-    std::srand(15780);  // set seed
+enum Algorithm { GBFHS, MME, ASTAR, IDASTAR, NUM_ALGORITHMS };
 
-    int eps = 1;
-    int discount = 5;
+/**
+ * @brief Options of a batch.
+ */
+struct Options {
+    /** @brief number of random instances */
+    int num_instances;
+    /** @brief number of workers, or 0 for one per hardware thread */
+    int num_threads;
+    /** @brief number of threads that expand each GBFHS level */
+    int search_threads;
+    /** @brief whether GBFHS and MMe run their directions concurrently,
+     * which excludes more than one search thread */
+    bool concurrent;
+    /** @brief numbers of threads to run HDA* with, if any */
+    std::vector<int> hda_threads;
+    /** @brief log2 of the size of the IDA* transposition table (0 for none),
+     * or -1 to skip IDA* */
+    int ida_table_bits;
+    /** @brief whether IDA* runs without GBFHS, MMe and A* */
+    bool ida_only;
+    /** @brief seed of the instances and of the random picks of GBFHS */
+    unsigned seed;
+    /** @brief heuristic of each direction of the n-puzzle */
+    HeuristicKinds heuristics;
+};
 
-    int gbfhs_nodes_expanded = 0;
-    int mme_nodes_expanded = 0;
-    int astar_nodes_expanded = 0;
-    std::ofstream gbfhs_out;
-    std::ofstream mme_out;
-    std::ofstream astar_out;
-    gbfhs_out.open("experiments/gbfhs_8puzzle_50_" + std::to_string(discount) + ".txt", std::ofstream::trunc);
-    mme_out.open("experiments/mme_8puzzle_50_" + std::to_string(discount) + ".txt", std::ofstream::trunc);
-    astar_out.open("experiments/astar_8puzzle_50_" + std::to_string(discount) + ".txt", std::ofstream::trunc);
-
-    /* 10-pancake problem */
-    gbfhs_nodes_expanded = 0;
-    mme_nodes_expanded = 0;
-    astar_nodes_expanded = 0;
-    for (int i = 0; i < NUM_ITERS; ++i) {
+/**
+ * @brief Result of one algorithm on one instance.
+ */
+struct Result {
+    /** @brief optimal cost found */
+    int opt;
+    /** @brief counters of the solve */
+    Counters counters;
+};
+
+/**
+ * @brief Tells whether an algorithm runs in a batch.
+ *
+ * @param algorithm Algorithm.
+ * @param options Options of the batch.
+ * @return True if the algorithm runs on every instance.
+ */
+bool is_enabled(Algorithm algorithm, const Options &options) {
+    if (algorithm == IDASTAR) {
+        return options.ida_table_bits >= 0;
+    }
+    return !options.ida_only;
+}
+
+/**
+ * @brief Solvers of one worker, which keep their tables allocated across the
+ * jobs of the worker.
+ */
+template <class Store>
+struct Solvers {
+    GbfhsSolver<Store> gbfhs;
+    MmeSolver<Store> mme;
+    AStarSolver<Store> astar;
+    IdaStarSolver<typename Store::Domain> ida;
+
+    /**
+     * @brief Constructor.
+     */
+    Solvers(int eps, int discount, const Options &options)
+        : gbfhs(eps, discount, options.heuristics), mme(eps, discount, options.heuristics),
+          astar(discount, options.heuristics),
+          ida(discount, options.heuristics, std::max(options.ida_table_bits, 0))
+    {
+        if (options.concurrent) {
+            gbfhs.set_concurrent(true);
+            mme.set_concurrent(true);
+        } else {
+            gbfhs.set_num_threads(options.search_threads);
+        }
+    }
+};
+
+/**
+ * @brief Draws random solvable instances with the goal state in order.
+ *
+ * @param num_instances Number of instances.
+ * @param gs Goal state.
+ * @return Initial states.
+ */
+template <class P>
+std::vector<typename P::State> make_instances(int num_instances, typename P::State gs) {
+    std::vector<typename P::State> instances;
+    for (int i = 0; i < num_instances; ++i) {
         /* random initial state */
         std::vector<int> initial_state;
-        std::vector<int> goal_state;
-        for (int i = 0; i < BOARD_DIM * BOARD_DIM; ++i) {
-            initial_state.push_back(i);
-            goal_state.push_back(i);
+        for (int j = 0; j < P::SIZE; ++j) {
+            initial_state.push_back(j);
         }
         while (true) {
             std::random_shuffle(initial_state.begin(), initial_state.end());
-            if (get_num_inversions(initial_state) % 2 == 0) {
+            if (P::is_solvable(P::pack(initial_state), gs)) {
                 break;
             }
         }
-        
-        int nodes_expanded = 0;
-        int gbfhs_opt = gbfhs(initial_state, goal_state, eps, discount, nodes_expanded);
-        gbfhs_nodes_expanded += nodes_expanded;
-        gbfhs_out << nodes_expanded << std::endl;
-        std::cout << "GBFHS opt: " << gbfhs_opt << std::endl;
-        std::cout << "nodes expanded: " << nodes_expanded << std::endl;
-
-        nodes_expanded = 0;
-        int mme_opt = mme(initial_state, goal_state, eps, discount, nodes_expanded);
-        mme_nodes_expanded += nodes_expanded;
-        mme_out << nodes_expanded << std::endl;
-        std::cout << "MMe opt: " << mme_opt << std::endl;
-        std::cout << "nodes expanded: " << nodes_expanded << std::endl;
-
-        nodes_expanded = 0;
-        int astar_opt = astar(initial_state, goal_state, discount, nodes_expanded);
-        astar_nodes_expanded += nodes_expanded;
-        astar_out << nodes_expanded << std::endl;
-        std::cout << "A* opt: " << astar_opt << std::endl;
-        std::cout << "nodes expanded: " << nodes_expanded << std::endl;
-
-        if (gbfhs_opt != mme_opt) {
-            std::cout << "GBFHS optimal_cost: " << gbfhs_opt << std::endl;
-            std::cout << "MMe optimal cost: " << mme_opt << std::endl;
-            print_puzzle(initial_state);
+        instances.push_back(P::pack(initial_state));
+    }
+    return instances;
+}
+
+/**
+ * @brief Prints the result of one algorithm on one instance.
+ *
+ * @param name Name of the algorithm.
+ * @param result Result to print.
+ * @return Void.
+ */
+void print_result(const std::string &name, const Result &result) {
+    const Counters &counters = result.counters;
+    std::cout << name << " opt: " << result.opt << std::endl;
+    std::cout << "nodes expanded: " << counters.nodes_expanded << std::endl;
+    std::cout << "moves pruned: " << counters.moves_pruned << std::endl;
+    std::cout << "nodes generated: " << counters.nodes_generated << std::endl;
+    std::cout << "arena allocations: " << counters.arena.allocations << " (" << counters.arena.reused << " reused), "
+        << counters.arena.bytes << " bytes" << std::endl;
+}
+
+/**
+ * @brief Gets the part of the experiment file names that names the
+ * heuristics: the discount, which is left out if no direction uses
+ * Manhattan distance since it degrades nothing else, followed by the kind
+ * of each direction unless both use Manhattan distance.
+ *
+ * @param discount Used for degrading the heuristic.
+ * @param options Options of the batch.
+ * @return Suffix such as "_5_pdb_manhattan".
+ */
+std::string get_heuristic_suffix(int discount, const Options &options) {
+    bool manhattan_F = options.heuristics[Direction::F] == TileHeuristic::Manhattan;
+    bool manhattan_B = options.heuristics[Direction::B] == TileHeuristic::Manhattan;
+    std::string suffix = (manhattan_F || manhattan_B) ? "_" + std::to_string(discount) : "";
+    if (manhattan_F && manhattan_B) {
+        return suffix;
+    }
+    for (TileHeuristic kind : options.heuristics) {
+        suffix += (kind == TileHeuristic::AdditivePdb) ? "_pdb" : "_manhattan";
+    }
+    return suffix;
+}
+
+/**
+ * @brief Runs HDA* on every instance with each number of threads and reports
+ * its scaling.
+ * 
+ * Instances are solved one after another, each with all the threads, and
+ * every cost is checked against the one found by A*. Next to the speedup,
+ * the search overhead compares the nodes expanded with those of A*, so
+ * extra work done by the threads shows up apart from the wall time.
+ * 
+ * @param discount Used for degrading the heuristic.
+ * @param instances Initial states.
+ * @param gs Goal state.
+ * @param opts Optimal cost of each instance.
+ * @param astar_nodes_expanded Nodes expanded by A* over all instances.
+ * @param options Options of the batch.
+ * @return Void.
+ */
+template <class Store>
+void run_scaling(int discount, const std::vector<typename Store::State> &instances, typename Store::State gs,
+                 const std::vector<int> &opts, long astar_nodes_expanded, const Options &options) {
+    typedef typename Store::Domain P;
+    int num_instances = instances.size();
+    std::ofstream scaling_out;
+    scaling_out.open("experiments/hdastar_" + P::get_name() + "_" + std::to_string(num_instances)
+        + get_heuristic_suffix(discount, options) + ".txt", std::ofstream::trunc);
+
+    double base_seconds = 0;
+    for (int num_threads : options.hda_threads) {
+        HdaStarSolver<Store> solver(discount, options.heuristics, num_threads);
+        long nodes_expanded = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < num_instances; ++i) {
+            int opt = solver.solve(instances[i], gs);
+            nodes_expanded += solver.get_counters().nodes_expanded;
+            if (opt != opts[i]) {
+                std::cout << "HDA* optimal cost: " << opt << std::endl;
+                std::cout << "A* optimal cost: " << opts[i] << std::endl;
+                P::print_state(instances[i]);
+                exit(-1);
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (base_seconds == 0) {
+            base_seconds = seconds;
+        }
+        double overhead = static_cast<double>(nodes_expanded) / std::max(astar_nodes_expanded, 1L);
+        std::cout << "HDA* " << solver.get_num_threads() << " threads: avg nodes expanded "
+            << nodes_expanded / num_instances << ", wall time " << seconds << " s, speedup "
+            << base_seconds / seconds << ", search overhead " << overhead << std::endl;
+        scaling_out << solver.get_num_threads() << " " << seconds << " " << nodes_expanded / num_instances
+            << " " << overhead << std::endl;
+    }
+    std::cout << std::endl;
+    scaling_out.close();
+}
+
+/**
+ * @brief Runs the experiments with every algorithm using the given store, on
+ * random instances of its domain.
+ *
+ * @param eps Integer representing the minimum-cost operator in the domain.
+ * @param discount Used for degrading the heuristic.
+ * @param options Options of the batch.
+ * @return Void.
+ */
+template <class Store>
+void run_experiments(int eps, int discount, const Options &options) {
+    typedef typename Store::Domain P;
+    typedef typename Store::State State;
+    std::string name = P::get_name();
+    int num_instances = options.num_instances;
+
+    std::ofstream gbfhs_out;
+    std::ofstream mme_out;
+    std::ofstream astar_out;
+    std::string suffix = "_" + std::to_string(num_instances) + get_heuristic_suffix(discount, options) + ".txt";
+    if (!options.ida_only) {
+        gbfhs_out.open("experiments/gbfhs_" + name + suffix, std::ofstream::trunc);
+        mme_out.open("experiments/mme_" + name + suffix, std::ofstream::trunc);
+        astar_out.open("experiments/astar_" + name + suffix, std::ofstream::trunc);
+    }
+
+    std::vector<int> goal_state;
+    for (int i = 0; i < P::SIZE; ++i) {
+        goal_state.push_back(i);
+    }
+    State gs = P::pack(goal_state);
+    std::vector<State> instances = make_instances<P>(num_instances, gs);
+    for (const State &instance : instances) {
+        P::Heuristic::prepare(instance, gs, options.heuristics);
+    }
+
+    /* job j runs algorithm j % NUM_ALGORITHMS on instance j / NUM_ALGORITHMS */
+    std::vector<Result> results(num_instances * NUM_ALGORITHMS);
+    WorkStealingPool pool(options.num_threads);
+    std::vector<std::unique_ptr<Solvers<Store>>> solvers(pool.get_num_threads());
+    auto start = std::chrono::steady_clock::now();
+    pool.run(results.size(), [&](std::size_t job, int worker) {
+        if (!solvers[worker]) {
+            solvers[worker].reset(new Solvers<Store>(eps, discount, options));
+        }
+        Solvers<Store> &solver = *solvers[worker];
+        int i = job / NUM_ALGORITHMS;
+        Result &result = results[job];
+        Algorithm algorithm = static_cast<Algorithm>(job % NUM_ALGORITHMS);
+        if (!is_enabled(algorithm, options)) {
+            return;
+        }
+        switch (algorithm) {
+        case GBFHS:
+            solver.gbfhs.seed(options.seed + i);
+            result.opt = solver.gbfhs.solve(instances[i], gs);
+            result.counters = solver.gbfhs.get_counters();
+            break;
+        case MME:
+            result.opt = solver.mme.solve(instances[i], gs);
+            result.counters = solver.mme.get_counters();
+            break;
+        case ASTAR:
+            result.opt = solver.astar.solve(instances[i], gs);
+            result.counters = solver.astar.get_counters();
+            break;
+        case IDASTAR:
+            result.opt = solver.ida.solve(instances[i], gs);
+            result.counters = solver.ida.get_counters();
+            break;
+        default:
+            break;
+        }
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    long gbfhs_nodes_expanded = 0;
+    long mme_nodes_expanded = 0;
+    long astar_nodes_expanded = 0;
+    long ida_nodes_expanded = 0;
+    for (int i = 0; i < num_instances; ++i) {
+        const Result &gbfhs_result = results[i * NUM_ALGORITHMS + GBFHS];
+        const Result &mme_result = results[i * NUM_ALGORITHMS + MME];
+        const Result &astar_result = results[i * NUM_ALGORITHMS + ASTAR];
+        const Result &ida_result = results[i * NUM_ALGORITHMS + IDASTAR];
+
+        if (is_enabled(IDASTAR, options)) {
+            ida_nodes_expanded += ida_result.counters.nodes_expanded;
+            std::cout << "IDA* opt: " << ida_result.opt << std::endl;
+            std::cout << "nodes expanded: " << ida_result.counters.nodes_expanded << std::endl;
+            std::cout << "transpositions: " << ida_result.counters.transpositions << std::endl;
+        }
+        if (options.ida_only) {
+            continue;
+        }
+
+        gbfhs_nodes_expanded += gbfhs_result.counters.nodes_expanded;
+        gbfhs_out << gbfhs_result.counters.nodes_expanded << std::endl;
+        print_result("GBFHS", gbfhs_result);
+
+        mme_nodes_expanded += mme_result.counters.nodes_expanded;
+        mme_out << mme_result.counters.nodes_expanded << std::endl;
+        print_result("MMe", mme_result);
+
+        astar_nodes_expanded += astar_result.counters.nodes_expanded;
+        astar_out << astar_result.counters.nodes_expanded << std::endl;
+        print_result("A*", astar_result);
+        std::cout << "nodes pushed: " << astar_result.counters.nodes_pushed << std::endl;
+        std::cout << "stale pops: " << astar_result.counters.stale_popped << std::endl;
+
+        if (is_enabled(IDASTAR, options)) {
+            if (ida_result.opt != astar_result.opt) {
+                std::cout << "IDA* optimal cost: " << ida_result.opt << std::endl;
+                std::cout << "A* optimal cost: " << astar_result.opt << std::endl;
+                P::print_state(instances[i]);
+                exit(-1);
+            }
+        }
+
+        if (gbfhs_result.opt != mme_result.opt) {
+            std::cout << "GBFHS optimal_cost: " << gbfhs_result.opt << std::endl;
+            std::cout << "MMe optimal cost: " << mme_result.opt << std::endl;
+            P::print_state(instances[i]);
             exit(-1);
         }
-        
     }
-    std::cout << "GBFHS avg nodes expanded: " << gbfhs_nodes_expanded / NUM_ITERS << std::endl;
-    std::cout << "MMe avg nodes expanded: " << mme_nodes_expanded / NUM_ITERS << std::endl;
-    std::cout << "A* avg nodes expanded: " << astar_nodes_expanded / NUM_ITERS << std::endl;
+    if (!options.ida_only) {
+        std::cout << "GBFHS avg nodes expanded: " << gbfhs_nodes_expanded / num_instances << std::endl;
+        std::cout << "MMe avg nodes expanded: " << mme_nodes_expanded / num_instances << std::endl;
+        std::cout << "A* avg nodes expanded: " << astar_nodes_expanded / num_instances << std::endl;
+    }
+    if (is_enabled(IDASTAR, options)) {
+        std::cout << "IDA* avg nodes expanded: " << ida_nodes_expanded / num_instances << std::endl;
+    }
+    std::cout << "wall time: " << seconds << " s on " << pool.get_num_threads() << " threads" << std::endl;
     std::cout << std::endl;
 
+    if (options.ida_only) {
+        return;
+    }
+    if (!options.hda_threads.empty()) {
+        std::vector<int> opts;
+        for (int i = 0; i < num_instances; ++i) {
+            opts.push_back(results[i * NUM_ALGORITHMS + ASTAR].opt);
+        }
+        run_scaling<Store>(discount, instances, gs, opts, astar_nodes_expanded, options);
+    }
+
     gbfhs_out << std::endl;
     mme_out << std::endl;
     astar_out << std::endl;
@@ -97,6 +398,150 @@ int main() {
     gbfhs_out.close();
     mme_out.close();
     astar_out.close();
-    
+}
+
+/**
+ * @brief Main function.
+ *
+ * Usage: ./main [-j threads] [-t threads | -c] [-p threads,...] [-i bits | -I bits] [-h kind[,kind]] [-n instances] [-s seed] [3|4|5] [hash|dense]
+ *        ./main [-j threads] [-t threads | -c] [-p threads,...] [-i bits | -I bits] [-n instances] [-s seed] pancake [8|12|16] [x]
+ *
+ * The first optional argument is the board dimension of the n-puzzle
+ * (default 3). The second selects how the algorithms store their open and
+ * closed sets and costs: in hash tables (default) or in flat arrays indexed
+ * by state rank, which is only available for the 3x3 board. The pancake
+ * problem takes the number of pancakes instead (default 12) and the x of its
+ * GAP-x heuristic (default 2), and always uses hash tables.
+ *
+ * -j sets the number of workers (default 1; 0 for one per hardware thread),
+ * -t the number of threads that expand each GBFHS level (default 1, which
+ * expands in random order; 0 for one per hardware thread), -c instead
+ * expands the forward and backward directions of GBFHS and MMe on a thread
+ * each, with the same expansions as the serial search,
+ * -p runs HDA* afterwards with each of the given numbers of threads and
+ * reports its scaling, -i also runs IDA* with a transposition table of
+ * 2^bits entries (0 for none, at most MAX_IDA_TABLE_BITS) and checks its
+ * costs against A*, -I runs IDA* alone, for instances too large for the
+ * best-first algorithms, -h selects the heuristic of the n-puzzle,
+ * manhattan (default) or pdb for additive pattern databases, in both
+ * directions or, given two kinds, in the forward and backward directions in
+ * turn (pdb is not available on the 5x5 board), -n sets the number of
+ * random instances (default NUM_ITERS) and -s the seed (default 15780).
+ */
+int main(int argc, char **argv) {
+    Options options;
+    options.num_instances = NUM_ITERS;
+    options.num_threads = 1;
+    options.search_threads = 1;
+    options.concurrent = false;
+    options.ida_table_bits = -1;
+    options.ida_only = false;
+    options.seed = 15780;
+    options.heuristics[Direction::F] = TileHeuristic::Manhattan;
+    options.heuristics[Direction::B] = TileHeuristic::Manhattan;
+    bool bad_heuristic = false;
+    bool bad_ida_bits = false;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-c") {
+            options.concurrent = true;
+        } else if (arg == "-p" && i + 1 < argc) {
+            std::stringstream list(argv[++i]);
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                options.hda_threads.push_back(std::atoi(item.c_str()));
+            }
+        } else if (arg == "-h" && i + 1 < argc) {
+            std::stringstream list(argv[++i]);
+            std::string item;
+            std::vector<TileHeuristic> kinds;
+            while (std::getline(list, item, ',')) {
+                bad_heuristic |= item != "manhattan" && item != "pdb";
+                kinds.push_back((item == "pdb") ? TileHeuristic::AdditivePdb : TileHeuristic::Manhattan);
+            }
+            bad_heuristic |= kinds.empty() || kinds.size() > 2;
+            if (!kinds.empty()) {
+                options.heuristics[Direction::F] = kinds.front();
+                options.heuristics[Direction::B] = kinds.back();
+            }
+        } else if ((arg == "-j" || arg == "-t" || arg == "-i" || arg == "-I" || arg == "-n" || arg == "-s")
+                   && i + 1 < argc) {
+            int value = std::atoi(argv[++i]);
+            if (arg == "-i" || arg == "-I") {
+                bad_ida_bits |= value < 0 || value > MAX_IDA_TABLE_BITS;
+                options.ida_table_bits = value;
+                options.ida_only = arg == "-I";
+            } else if (arg == "-j") {
+                options.num_threads = value;
+            } else if (arg == "-t") {
+                options.search_threads = value;
+            } else if (arg == "-n") {
+                options.num_instances = std::max(1, value);
+            } else {
+                options.seed = value;
+            }
+        } else {
+            args.push_back(arg);
+        }
+    }
+    if (bad_ida_bits) {
+        std::cerr << "IDA* table bits must be between 0 and " << MAX_IDA_TABLE_BITS << std::endl;
+        return 1;
+    }
+    if (options.concurrent && options.search_threads != 1) {
+        std::cerr << "-c runs one thread per direction and cannot be combined with -t" << std::endl;
+        return 1;
+    }
+    if (options.ida_only && !options.hda_threads.empty()) {
+        std::cerr << "-p needs the costs found by A*, which -I does not run" << std::endl;
+        return 1;
+    }
+    std::srand(options.seed);  // set seed
+
+    int eps = 1;
+    int discount = 5;
+
+    std::string domain = (args.size() > 0) ? args[0] : "3";
+    bool pdb = options.heuristics[Direction::F] == TileHeuristic::AdditivePdb
+        || options.heuristics[Direction::B] == TileHeuristic::AdditivePdb;
+    if (bad_heuristic) {
+        std::cerr << "unknown heuristic; expected manhattan or pdb" << std::endl;
+        return 1;
+    }
+    if (domain == "pancake") {
+        int n = (args.size() > 1) ? std::atoi(args[1].c_str()) : 12;
+        int gap_x = (args.size() > 2) ? std::atoi(args[2].c_str()) : 2;
+        if (pdb) {
+            std::cerr << "the pancake problem has no pattern databases" << std::endl;
+            return 1;
+        } else if (n == 8) {
+            run_experiments<HashStore<Pancake<8>>>(eps, gap_x, options);
+        } else if (n == 12) {
+            run_experiments<HashStore<Pancake<12>>>(eps, gap_x, options);
+        } else if (n == 16) {
+            run_experiments<HashStore<Pancake<16>>>(eps, gap_x, options);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [-j threads] [-t threads | -c] [-p threads,...] [-i bits | -I bits] [-n instances] [-s seed] pancake [8|12|16] [x]" << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    int dim = std::atoi(domain.c_str());
+    std::string store = (args.size() > 1) ? args[1] : "hash";
+    if (dim == 3 && store == "hash") {
+        run_experiments<HashStore<Puzzle<3>>>(eps, discount, options);
+    } else if (dim == 3 && store == "dense") {
+        run_experiments<DenseStore<Puzzle<3>>>(eps, discount, options);
+    } else if (dim == 4 && store == "hash") {
+        run_experiments<HashStore<Puzzle<4>>>(eps, discount, options);
+    } else if (dim == 5 && store == "hash" && !pdb) {
+        run_experiments<HashStore<Puzzle<5>>>(eps, discount, options);
+    } else {
+        std::cerr << "usage: " << argv[0] << " [-j threads] [-t threads | -c] [-p threads,...] [-i bits | -I bits] [-h kind[,kind]] [-n instances] [-s seed] [3|4|5] [hash|dense]" << std::endl;
+        return 1;
+    }
+
     return 0;
-}
\ No newline at end of file
+}
@@ -1,96 +1,63 @@
 /**
  * @file mme.cpp
- * @brief MMe implementation for n-puzzle problem.
+ * @brief MMe implementation, generic over the search domain.
  * 
  * @author Andrew Gu (andrewg2)
  * @bug 
  */
 
 #include "mme.h"
+#include "puzzle.h"
+#include "pancake.h"
 
 #include <limits.h>
 #include <assert.h>
 
 /**
- * @brief Return the priority of the given node in the given direction.
+ * @brief Constructor.
  * 
- * The priority of node n in direction D is given by:
- *     pr_D(n) := max(f_D(n), 2g_D(n) + eps)
- * 
- * @param node Node to get the priority of.
- * @param eps Minimum cost operator on the node.
- * @param dir Direction.
- * @param is Initial state.
- * @param gs Goal state.
+ * @param eps Integer representing the minimum-cost operator in the domain,
+ * i.e. the cheapest edge in the state space.
  * @param discount Used for degrading the heuristic.
- * @param g_D Map from nodes to cost in direction dir.
- * @return Priority of the node.
+ * @param kinds Kind of heuristic of each direction.
  */
-int pr(const Node &node, int eps, Direction dir, const std::vector<int> &is, const std::vector<int> &gs, int discount, const NodeIntMap &g_D) {
-    assert(dir == Direction::F || dir == Direction::B);
-    assert(g_D.count(node) > 0);
-    int g_D_ = g_D.find(node)->second;
-    int h_D = (dir == Direction::F) ? h(node.s, gs, discount) : h(node.s, is, discount);
-    int f_D = g_D_ + h_D;
-    return std::max(f_D, 2 * g_D_ + eps);
-}
+template <class Store>
+MmeSolver<Store>::MmeSolver(int eps, int discount, const HeuristicKinds &kinds)
+    : eps_(eps), discount_(discount), kinds_(kinds), arena_(counters_.arena),
+      store_(arena_.make<Store>()),
+      queue_F_(arena_.make<MmeQueue<Store>>(Direction::F, eps)),
+      queue_B_(arena_.make<MmeQueue<Store>>(Direction::B, eps))
+{}
 
 /**
- * @brief Scans over the open set for the given direction to collect prmin_D,
- * fmin_D, and gmin_D and return the optimal node to expand.
- *
- * The optimal node to expand is the node n with pr_D(n) == prmin_D and
- * minimal g_D(n) in the case of ties.
+ * @brief Turns the concurrent mode on or off.
  * 
- * @param open_D Open set to scan.
- * @param eps Minimum cost operator.
- * @param dir Direction of the open set to scan.
- * @param is Initial state.
- * @param gs Goal state.
- * @param discount Used for degrading the heuristic.
- * @param prmin_D (output) Minimum priority on open_D.
- * @param fmin_D (output) Minumum f on open_D.
- * @param gmin_D (output) Minimum g on open_D.
- * @param g_D Map from nodes to costs in direction dir.
- * @return Node with pr_D(n) == prmin_D and minimal g_D(n).
+ * In the concurrent mode, the forward direction runs on the calling thread
+ * and the backward direction on a thread that lives as long as the solver.
+ * The counters are those of the serial loop.
+ * 
+ * @param concurrent True to give each direction a worker.
+ * @return Void.
  */
-Node scan(const NodeSet &open_D, int eps, Direction dir, const std::vector<int> &is, const std::vector<int> &gs, int discount, int &prmin_D, int &fmin_D, int &gmin_D, const NodeIntMap &g_D) {
-    assert(!open_D.empty());
-    assert(dir == Direction::F || dir == Direction::B);
-
-    prmin_D = INT_MAX;
-    fmin_D = INT_MAX;
-    gmin_D = INT_MAX;
-
-    /* node n with pr_D(n) == prmin_D and minimal g_D(n) for ties */
-    const Node *opt_node = &(*open_D.begin());
-    int g_D_ = INT_MAX;
-
-    for (const Node &node : open_D) {
-        int pr_D = pr(node, eps, dir, is, gs, discount, g_D);
-        assert(g_D.count(node) > 0);
-        int g_D_node = g_D.find(node)->second;
-
-        /* strictly smaller priority */
-        if (pr_D < prmin_D) {
-            opt_node = &node;
-            prmin_D = pr_D;    
-            g_D_ = g_D_node;
-        }
-        /* equal priority but strictly smaller g_D */
-        else if (pr_D == prmin_D) {
-            if (g_D.count(node) > 0 && g_D.find(node)->second < g_D_) {
-                opt_node = &node;
-                g_D_ = g_D_node;
-            }
-        }
-
-        fmin_D = std::min(fmin_D, g_D_node + h(node.s, (dir == Direction::F) ? gs : is, discount));
-        gmin_D = std::min(gmin_D, g_D_node);
+template <class Store>
+void MmeSolver<Store>::set_concurrent(bool concurrent) {
+    for (int d = Direction::F; d <= Direction::B; ++d) {
+        sides_[d].reset(concurrent ? new Side(static_cast<Direction>(d), eps_) : nullptr);
     }
+    pool_.reset(concurrent ? new WorkStealingPool(2) : nullptr);
+}
 
-    assert(opt_node != nullptr);
-    return *opt_node;
+/**
+ * @brief Clears the store and the queues, keeping their memory for the next
+ * solve.
+ * 
+ * @return Void.
+ */
+template <class Store>
+void MmeSolver<Store>::reset() {
+    store_.clear();
+    queue_F_.clear();
+    queue_B_.clear();
 }
 
 /**
@@ -98,77 +65,352 @@ Node scan(const NodeSet &open_D, int eps, Direction dir, const std::vector<int>
  * 
  * @param initial_state Initial state.
  * @param goal_state Goal state.
- * @param eps Integer representing the minimum-cost operator in the domain,
- * i.e. the cheapest edge in the state space.
- * @param discount Used for degrading the heuristic.
- * @param nodes_expanded (output) Number of nodes expanded.
  * @return Optimal cost.
  */
-int mme(const std::vector<int> &initial_state, const std::vector<int> &goal_state, int eps, int discount, int &nodes_expanded) {
+template <class Store>
+int MmeSolver<Store>::solve(State initial_state, State goal_state) {
     int U = INT_MAX;  // unsolvable
-    nodes_expanded = 0;
+    counters_ = Counters();
+    if (sides_[Direction::F]) {
+        return solve_concurrent(initial_state, goal_state);
+    }
 
-    /* initialize node sets */
-    NodeSet open_F, open_B, closed_F, closed_B;
-    open_F.emplace(initial_state, Direction::F);
-    open_B.emplace(goal_state, Direction::B);
+    /* containers built during the solve take their memory from the arena */
+    Arena::Scope scope(arena_);
+    reset();
 
-    /* initialize cost data structures */
-    NodeIntMap g_F, g_B;
-    g_F.emplace(std::make_pair(Node { initial_state, Direction::F }, 0));
-    g_B.emplace(std::make_pair(Node { goal_state, Direction::B }, 0));    
+    /* the only heuristic values computed from scratch are the roots' */
+    typename P::Heuristic heuristic(initial_state, goal_state, discount_, kinds_);
 
-    /* main loop */
-    while (!open_F.empty() && !open_B.empty()) {
-        int fmin_F, fmin_B, gmin_F, gmin_B, prmin_F, prmin_B;
+    /* initialize node sets and costs */
+    Node initial_node = P::make_root(initial_state, Direction::F, heuristic);
+    Node goal_node = P::make_root(goal_state, Direction::B, heuristic);
+    Handle initial_h = store_.insert(initial_state, initial_node.hash);
+    store_.set_g(initial_h, Direction::F, 0);
+    store_.mark_open(initial_h, initial_node, Direction::F);
+    Handle goal_h = store_.insert(goal_state, goal_node.hash);
+    store_.set_g(goal_h, Direction::B, 0);
+    store_.mark_open(goal_h, goal_node, Direction::B);
+    queue_F_.push(initial_node, 0);
+    queue_B_.push(goal_node, 0);
 
-        Node node_F = scan(open_F, eps, Direction::F, initial_state, goal_state, discount, prmin_F, fmin_F, gmin_F, g_F);
-        Node node_B = scan(open_B, eps, Direction::B, initial_state, goal_state, discount, prmin_B, fmin_B, gmin_B, g_B);
+    /* main loop */
+    while (!store_.open_empty(Direction::F) && !store_.open_empty(Direction::B)) {
+        int prmin_F = queue_F_.get_prmin();
+        int prmin_B = queue_B_.get_prmin();
+        int fmin_F = queue_F_.get_fmin();
+        int fmin_B = queue_B_.get_fmin();
+        int gmin_F = queue_F_.get_gmin();
+        int gmin_B = queue_B_.get_gmin();
         int C = std::min(prmin_F, prmin_B);
-        if (U <= std::max(std::max(C, fmin_F), std::max(fmin_B, gmin_F + gmin_B + eps))) {
+        if (U <= std::max(std::max(C, fmin_F), std::max(fmin_B, gmin_F + gmin_B + eps_))) {
             return U;
         }
 
-        Node &node = (C == prmin_F) ? node_F : node_B;
-        NodeSet &open_D = (C == prmin_F) ? open_F : open_B;
-        NodeSet &open_D_opp = (C == prmin_F) ? open_B : open_F;
-        NodeSet &closed_D = (C == prmin_F) ? closed_F : closed_B;
-        NodeIntMap &g_D = (C == prmin_F) ? g_F : g_B;
-        NodeIntMap &g_D_opp = (C == prmin_F) ? g_B : g_F;
+        Direction dir = (C == prmin_F) ? Direction::F : Direction::B;
+        Direction opp = (dir == Direction::F) ? Direction::B : Direction::F;
+        MmeQueue<Store> &queue_D = (dir == Direction::F) ? queue_F_ : queue_B_;
+        Node node = queue_D.pop(store_);
 
         /* mark node as closed */
-        open_D.erase(node);
-        closed_D.insert(node);
+        Handle node_h = store_.find(node.s, node.hash);
+        store_.close(node_h, dir);
         
         /* iterate over successor nodes */
-        NodeVector successors = expand(node, nodes_expanded);
+        int g_D_node = store_.get_g(node_h, dir);
+        typename P::NodeVector successors = P::expand(node, heuristic, counters_);
         for (Node &s_node : successors) {
+            Handle s_node_h = store_.insert(s_node.s, s_node.hash);
+
             /* continue if node visits s_node via a suboptimal path */
-            bool already_seen = open_D.count(s_node) > 0 || closed_D.count(s_node) > 0;
+            bool already_seen = store_.is_open(s_node_h, dir) || store_.is_closed(s_node_h, dir);
             if (already_seen) {
-                assert(g_D.count(node) > 0 && g_D.count(s_node) > 0);
-                bool suboptimal_cost = g_D[node] + 1 >= g_D[s_node];  // assumes unit cost
+                assert(store_.has_g(s_node_h, dir));
+                bool suboptimal_cost = g_D_node + 1 >= store_.get_g(s_node_h, dir);  // assumes unit cost
                 if (suboptimal_cost) {
                     continue;
                 }
             }
 
             /* node visits s_node via a cheaper path */
-            open_D.erase(s_node);
-            closed_D.erase(s_node);
-
-            if (g_D.count(s_node) > 0) {
-                assert(g_D[s_node] > g_D[node] + 1);
+            if (store_.has_g(s_node_h, dir)) {
+                assert(store_.get_g(s_node_h, dir) > g_D_node + 1);
+            }
+            if (store_.is_open(s_node_h, dir)) {
+                queue_D.remove(s_node, store_.get_g(s_node_h, dir));
             }
-            g_D[s_node] = g_D[node] + 1;  // assumes unit cost
-            open_D.insert(s_node);
+            store_.set_g(s_node_h, dir, g_D_node + 1);  // assumes unit cost
+            store_.mark_open(s_node_h, s_node, dir);
+            queue_D.push(s_node, g_D_node + 1);
 
             /* collision */
-            if (open_D_opp.count(s_node) > 0) {
-                assert(g_D.count(s_node) > 0 && g_D_opp.count(s_node) > 0);
-                U = std::min(U, g_D[s_node] + g_D_opp[s_node]);
+            if (store_.is_open(s_node_h, opp)) {
+                assert(store_.has_g(s_node_h, opp));
+                U = std::min(U, g_D_node + 1 + store_.get_g(s_node_h, opp));
+            }
+        }
+    }
+    return U;
+}
+
+/**
+ * @brief Expands up to the given number of nodes with pr_D == C of one
+ * direction in the concurrent mode, logging each expansion and each
+ * successor it opens.
+ * 
+ * Runs on the worker of the direction and touches nothing of the other
+ * direction. Successors with pr_D == C are expanded too, as the serial loop
+ * does before C can grow; with a consistent heuristic no successor has
+ * pr_D < C. The backward worker also keeps the prior of every state it
+ * changes, since the forward successors of C are checked against the
+ * backward store as it was before C.
+ * 
+ * @param dir Direction to expand.
+ * @param C Current value of min(prmin_F, prmin_B).
+ * @param max_pops Largest number of nodes to expand.
+ * @param heuristic Heuristic of the current solve.
+ * @return Void.
+ */
+template <class Store>
+void MmeSolver<Store>::expand_side(Direction dir, int C, std::size_t max_pops, const typename P::Heuristic &heuristic) {
+    Side &side = *sides_[dir];
+    Arena::Scope scope(side.arena);
+    bool keep_priors = dir == Direction::B;
+
+    /* main loop */
+    for (std::size_t i = 0; i < max_pops && !side.store.open_empty(dir) && side.queue.get_prmin() == C; ++i) {
+        side.pops.push_back(Pop{side.queue.get_fmin(), side.queue.get_gmin(), INT_MAX, side.counters});
+
+        /* mark node as closed */
+        Node node = side.queue.pop(side.store);
+        Handle node_h = side.store.find(node.s, node.hash);
+        if (keep_priors) {
+            side.priors.emplace(node.s, node.hash, Prior{true, side.store.get_g(node_h, dir)});
+        }
+        side.store.close(node_h, dir);
+
+        /* iterate over successor nodes */
+        int g = side.store.get_g(node_h, dir) + 1;  // assumes unit cost
+        typename P::NodeVector successors = P::expand(node, heuristic, side.counters);
+        for (Node &s_node : successors) {
+            Handle s_node_h = side.store.insert(s_node.s, s_node.hash);
+            bool has_g = side.store.has_g(s_node_h, dir);
+            if (has_g && g >= side.store.get_g(s_node_h, dir)) {
+                continue;
+            }
+            if (keep_priors) {
+                Prior prior{side.store.is_open(s_node_h, dir), has_g ? side.store.get_g(s_node_h, dir) : G_NONE};
+                side.priors.emplace(s_node.s, s_node.hash, prior);
+            }
+            if (side.store.is_open(s_node_h, dir)) {
+                side.queue.remove(s_node, side.store.get_g(s_node_h, dir));
+            }
+            side.store.set_g(s_node_h, dir, g);
+            side.store.mark_open(s_node_h, s_node, dir);
+            side.queue.push(s_node, g);
+            side.opened.push_back(Opened{s_node.s, s_node.hash, g, side.pops.size() - 1});
+        }
+    }
+}
+
+/**
+ * @brief Checks successors opened by the other direction for the current
+ * value of C against the store of this direction, as the serial loop saw
+ * it.
+ * 
+ * Runs on the worker of the direction between two steps of expansions. The
+ * forward successors come first in the serial loop, so they meet the
+ * backward store as it was before C, which is read through the priors. The
+ * backward successors meet the forward store as the forward direction left
+ * it, so they are only checked once it is done with C.
+ * 
+ * @param dir Direction whose store is read.
+ * @return Void.
+ */
+template <class Store>
+void MmeSolver<Store>::resolve_side(Direction dir) {
+    Side &side = *sides_[dir];
+    Side &other = *sides_[(dir == Direction::F) ? Direction::B : Direction::F];
+    for (const Opened &opened : other.opened) {
+        bool open = false;
+        int g_D = G_NONE;
+        const Prior *prior = side.priors.find(opened.s, opened.hash);
+        if (prior != nullptr) {
+            open = prior->open;
+            g_D = prior->g;
+        } else {
+            Handle h = side.store.find(opened.s, opened.hash);
+            if (h != NOT_FOUND && side.store.is_open(h, dir)) {
+                open = true;
+                g_D = side.store.get_g(h, dir);
+            }
+        }
+        if (open) {
+            Pop &pop = other.pops[opened.pop];
+            pop.best = std::min(pop.best, opened.g + g_D);
+        }
+    }
+}
+
+/**
+ * @brief Runs the MMe algorithm in the concurrent mode.
+ * 
+ * Each value of C is expanded in steps of at most STEP_POPS nodes per
+ * direction. After each step the workers resolve the collisions that can
+ * be resolved, and the logs are replayed in the serial order, forward
+ * expansions first: before each expansion, the termination test of the
+ * serial loop is made with the minima that the log recorded, and then the
+ * expansion's collisions lower U. Where a test holds, the serial loop
+ * returns U, and the counters are those the log recorded there, so the
+ * expansions that the workers made past that point are not counted. A
+ * replayed log is dropped, so the backward log only grows while the
+ * forward direction is still expanding C. Since no test holds while U is
+ * INT_MAX, the backward worker only runs ahead of the forward one until a
+ * solution is found; after that it waits for the forward expansions of C
+ * to end.
+ * 
+ * @param initial_state Initial state.
+ * @param goal_state Goal state.
+ * @return Optimal cost.
+ */
+template <class Store>
+int MmeSolver<Store>::solve_concurrent(State initial_state, State goal_state) {
+    int U = INT_MAX;  // unsolvable
+    Side &side_F = *sides_[Direction::F];
+    Side &side_B = *sides_[Direction::B];
+    typename P::Heuristic heuristic(initial_state, goal_state, discount_, kinds_);
+
+    /* initialize each direction's store and queue with its root */
+    State roots[2] = {initial_state, goal_state};
+    for (int d = Direction::F; d <= Direction::B; ++d) {
+        Direction dir = static_cast<Direction>(d);
+        Side &side = *sides_[dir];
+        Arena::Scope scope(side.arena);
+        side.counters = Counters();
+        side.store.clear();
+        side.queue.clear();
+        Node root = P::make_root(roots[dir], dir, heuristic);
+        Handle root_h = side.store.insert(roots[dir], root.hash);
+        side.store.set_g(root_h, dir, 0);
+        side.store.mark_open(root_h, root, dir);
+        side.queue.push(root, 0);
+    }
+    /* counters as of the last expansion that the serial loop made */
+    Counters counters_F;
+    Counters counters_B;
+
+    /* main loop; each value of C is expanded in steps and replayed */
+    while (!side_F.store.open_empty(Direction::F) && !side_B.store.open_empty(Direction::B)) {
+        int prmin_F = side_F.queue.get_prmin();
+        int prmin_B = side_B.queue.get_prmin();
+        int fmin_F = side_F.queue.get_fmin();
+        int fmin_B = side_B.queue.get_fmin();
+        int gmin_F = side_F.queue.get_gmin();
+        int gmin_B = side_B.queue.get_gmin();
+        int C = std::min(prmin_F, prmin_B);
+        if (U <= std::max(std::max(C, fmin_F), std::max(fmin_B, gmin_F + gmin_B + eps_))) {
+            break;
+        }
+
+        for (Side *side : {&side_F, &side_B}) {
+            side->pops.clear();
+            side->opened.clear();
+            side->priors.clear();
+        }
+        bool done[2] = {prmin_F != C, prmin_B != C};
+        while (!done[Direction::F] || !done[Direction::B]) {
+            pool_->run(2, [&](std::size_t d, __attribute__((unused)) int worker) {
+                if (!done[d] && (d == Direction::F || done[Direction::F] || U == INT_MAX)) {
+                    expand_side(static_cast<Direction>(d), C, STEP_POPS, heuristic);
+                }
+            });
+            for (int d = Direction::F; d <= Direction::B; ++d) {
+                Side &side = *sides_[d];
+                done[d] = side.store.open_empty(static_cast<Direction>(d)) || side.queue.get_prmin() != C;
+                assert(side.queue.get_prmin() >= C);
+            }
+            pool_->run(2, [&](std::size_t d, __attribute__((unused)) int worker) {
+                if (d == Direction::B || done[Direction::F]) {
+                    resolve_side(static_cast<Direction>(d));
+                }
+            });
+
+            /* forward expansions, against the backward minima before C */
+            for (const Pop &pop : side_F.pops) {
+                if (U <= std::max(std::max(C, pop.fmin), std::max(fmin_B, pop.gmin + gmin_B + eps_))) {
+                    counters_.add(pop.counters);
+                    counters_.add(counters_B);
+                    return U;
+                }
+                U = std::min(U, pop.best);
             }
+            side_F.pops.clear();
+            side_F.opened.clear();
+            if (!done[Direction::F]) {
+                continue;
+            }
+            counters_F = side_F.counters;
+            if (side_F.store.open_empty(Direction::F)) {
+                counters_.add(counters_F);
+                counters_.add(counters_B);
+                return U;
+            }
+
+            /* backward expansions, against the forward minima after C */
+            fmin_F = side_F.queue.get_fmin();
+            gmin_F = side_F.queue.get_gmin();
+            for (const Pop &pop : side_B.pops) {
+                if (U <= std::max(std::max(C, fmin_F), std::max(pop.fmin, gmin_F + pop.gmin + eps_))) {
+                    counters_.add(counters_F);
+                    counters_.add(pop.counters);
+                    return U;
+                }
+                U = std::min(U, pop.best);
+            }
+            side_B.pops.clear();
+            side_B.opened.clear();
         }
+        counters_F = side_F.counters;
+        counters_B = side_B.counters;
     }
+    counters_.add(counters_F);
+    counters_.add(counters_B);
     return U;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Runs the MMe algorithm with the given initial and goal state on a
+ * solver of its own.
+ * 
+ * @param initial_state Initial state.
+ * @param goal_state Goal state.
+ * @param eps Integer representing the minimum-cost operator in the domain,
+ * i.e. the cheapest edge in the state space.
+ * @param discount Used for degrading the heuristic.
+ * @param kinds Kind of heuristic of each direction.
+ * @param counters (output) Counters of the search.
+ * @return Optimal cost.
+ */
+template <class Store>
+int mme(typename Store::State initial_state, typename Store::State goal_state, int eps, int discount, const HeuristicKinds &kinds, Counters &counters) {
+    MmeSolver<Store> solver(eps, discount, kinds);
+    int cost = solver.solve(initial_state, goal_state);
+    counters = solver.get_counters();
+    return cost;
+}
+
+/* explicit instantiations */
+template class MmeSolver<HashStore<Puzzle<3>>>;
+template class MmeSolver<HashStore<Puzzle<4>>>;
+template class MmeSolver<HashStore<Puzzle<5>>>;
+template class MmeSolver<DenseStore<Puzzle<3>>>;
+template class MmeSolver<HashStore<Pancake<8>>>;
+template class MmeSolver<HashStore<Pancake<12>>>;
+template class MmeSolver<HashStore<Pancake<16>>>;
+template int mme<HashStore<Puzzle<3>>>(Puzzle<3>::State, Puzzle<3>::State, int, int, const HeuristicKinds &, Counters &);
+template int mme<HashStore<Puzzle<4>>>(Puzzle<4>::State, Puzzle<4>::State, int, int, const HeuristicKinds &, Counters &);
+template int mme<HashStore<Puzzle<5>>>(Puzzle<5>::State, Puzzle<5>::State, int, int, const HeuristicKinds &, Counters &);
+template int mme<DenseStore<Puzzle<3>>>(Puzzle<3>::State, Puzzle<3>::State, int, int, const HeuristicKinds &, Counters &);
+template int mme<HashStore<Pancake<8>>>(Pancake<8>::State, Pancake<8>::State, int, int, const HeuristicKinds &, Counters &);
+template int mme<HashStore<Pancake<12>>>(Pancake<12>::State, Pancake<12>::State, int, int, const HeuristicKinds &, Counters &);
+template int mme<HashStore<Pancake<16>>>(Pancake<16>::State, Pancake<16>::State, int, int, const HeuristicKinds &, Counters &);
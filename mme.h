@@ -1,6 +1,6 @@
 /**
  * @file mme.h
- * @brief Struct definitions and function interface for MMe.
+ * @brief Solver and function interface for MMe.
  * 
  * @author Andrew Gu (andrewg2)
  * @bug No known bugs.
@@ -8,7 +8,323 @@
 
 #pragma once
 
-#include "puzzle.h"
+#include "domain.h"
+#include "store.h"
+#include "pool.h"
+#include "bidir.h"
+
+#include <algorithm>
+#include <memory>
+#include <cstdlib>
+#include <limits.h>
+#include <assert.h>
+
+/**
+ * @brief Return the priority of the given node in the given direction.
+ * 
+ * The priority of node n in direction D is given by:
+ *     pr_D(n) := max(f_D(n), 2g_D(n) + eps)
+ * 
+ * @param node Node to get the priority of.
+ * @param g_D_ Cost of the node in the given direction.
+ * @param eps Minimum cost operator on the node.
+ * @param dir Direction.
+ * @return Priority of the node.
+ */
+template <class Node>
+int pr(const Node &node, int g_D_, int eps, Direction dir) {
+    assert(dir == Direction::F || dir == Direction::B);
+    int f_D = g_D_ + node.get_h(dir);
+    return std::max(f_D, 2 * g_D_ + eps);
+}
+
+/**
+ * @brief Open list of one direction of MMe, bucketed by priority and g.
+ * 
+ * Nodes are kept in buckets indexed by (pr_D, g_D), and the number of open
+ * nodes with each value of pr_D, f_D and g_D is counted, so prmin_D,
+ * fmin_D and gmin_D are read from cursors that only move past empty
+ * values. The caller reports every node that enters open_D with push() and
+ * every node that leaves it, or is reopened with a smaller g_D, with
+ * remove(). Removed nodes stay in their bucket until pop() meets them and
+ * finds their state closed or reached more cheaply in the store.
+ */
+template <class Store>
+class MmeQueue {
+public:
+    typedef typename Store::Domain::Node Node;
+
+    /**
+     * @brief Constructor.
+     * 
+     * @param dir Direction of the open list.
+     * @param eps Minimum cost operator.
+     */
+    MmeQueue(Direction dir, int eps)
+        : dir_(dir), eps_(eps), pr_cursor_(0), f_cursor_(0), g_cursor_(0)
+    {}
+
+    /**
+     * @brief Adds a node that entered open_D with cost g_D.
+     */
+    void push(const Node &node, int g_D) {
+        int pr_D = pr(node, g_D, eps_, dir_);
+        if (pr_D >= static_cast<int>(buckets_.size())) {
+            buckets_.resize(pr_D + 1);
+        }
+        ArenaVector<ArenaVector<Node>> &row = buckets_[pr_D];
+        if (g_D >= static_cast<int>(row.size())) {
+            row.resize(g_D + 1);
+        }
+        row[g_D].push_back(node);
+        count(node, g_D, 1);
+    }
+
+    /**
+     * @brief Removes every node, keeping the buckets and counts allocated.
+     */
+    void clear() {
+        for (ArenaVector<ArenaVector<Node>> &row : buckets_) {
+            for (ArenaVector<Node> &bucket : row) {
+                bucket.clear();
+            }
+        }
+        std::fill(pr_counts_.begin(), pr_counts_.end(), 0);
+        std::fill(f_counts_.begin(), f_counts_.end(), 0);
+        std::fill(g_counts_.begin(), g_counts_.end(), 0);
+        pr_cursor_ = 0;
+        f_cursor_ = 0;
+        g_cursor_ = 0;
+    }
+
+    /**
+     * @brief Removes a node with cost g_D from the counts of open_D.
+     */
+    void remove(const Node &node, int g_D) {
+        count(node, g_D, -1);
+    }
+
+    /**
+     * @brief Gets the minimum priority on open_D.
+     */
+    int get_prmin() {
+        return advance_min(pr_counts_, pr_cursor_);
+    }
+
+    /**
+     * @brief Gets the minimum f on open_D.
+     */
+    int get_fmin() {
+        return advance_min(f_counts_, f_cursor_);
+    }
+
+    /**
+     * @brief Gets the minimum g on open_D.
+     */
+    int get_gmin() {
+        return advance_min(g_counts_, g_cursor_);
+    }
+
+    /**
+     * @brief Removes and returns a node n with pr_D(n) == prmin_D and
+     * minimal g_D(n).
+     * 
+     * @param store Store used to recognize stale entries.
+     * @pre open_D is not empty.
+     */
+    Node pop(const Store &store) {
+        int prmin_D = get_prmin();
+        assert(prmin_D != INT_MAX);
+        ArenaVector<ArenaVector<Node>> &row = buckets_[prmin_D];
+        for (int g_D = 0; g_D < static_cast<int>(row.size()); ++g_D) {
+            ArenaVector<Node> &bucket = row[g_D];
+            while (!bucket.empty()) {
+                Node node = bucket.back();
+                bucket.pop_back();
+                Handle h = store.find(node.s, node.hash);
+                if (store.is_open(h, dir_) && store.get_g(h, dir_) == g_D) {
+                    remove(node, g_D);
+                    return node;
+                }
+            }
+        }
+        assert(false);  // counts say bucket prmin_D holds an open node
+        abort();
+    }
+
+private:
+    /**
+     * @brief Gets the lowest index at or after the cursor with a nonzero
+     * count, advancing the cursor to it.
+     * 
+     * @param counts Counts indexed by value.
+     * @param cursor (in/out) Lower bound on the lowest nonzero index.
+     * @return Lowest index with a nonzero count, or INT_MAX if there is none.
+     */
+    static int advance_min(const ArenaVector<int> &counts, int &cursor) {
+        while (cursor < static_cast<int>(counts.size()) && counts[cursor] == 0) {
+            cursor++;
+        }
+        return (cursor < static_cast<int>(counts.size())) ? cursor : INT_MAX;
+    }
+
+    /**
+     * @brief Adds delta to the count at the given index, growing the counts
+     * and lowering the cursor as needed.
+     * 
+     * @param counts Counts indexed by value.
+     * @param cursor (in/out) Lower bound on the lowest nonzero index.
+     * @param i Index to update.
+     * @param delta Change in the count.
+     * @return Void.
+     */
+    static void add_count(ArenaVector<int> &counts, int &cursor, int i, int delta) {
+        if (i >= static_cast<int>(counts.size())) {
+            counts.resize(i + 1, 0);
+        }
+        counts[i] += delta;
+        assert(counts[i] >= 0);
+        cursor = std::min(cursor, i);
+    }
+
+    /**
+     * @brief Adds delta to the counts of the node's pr_D, f_D and g_D.
+     */
+    void count(const Node &node, int g_D, int delta) {
+        add_count(pr_counts_, pr_cursor_, pr(node, g_D, eps_, dir_), delta);
+        add_count(f_counts_, f_cursor_, g_D + node.get_h(dir_), delta);
+        add_count(g_counts_, g_cursor_, g_D, delta);
+    }
+
+    Direction dir_;
+    int eps_;
+    /** @brief buckets_[pr][g] holds the nodes pushed with pr_D and g_D */
+    ArenaVector<ArenaVector<ArenaVector<Node>>> buckets_;
+    ArenaVector<int> pr_counts_;
+    ArenaVector<int> f_counts_;
+    ArenaVector<int> g_counts_;
+    int pr_cursor_;
+    int f_cursor_;
+    int g_cursor_;
+};
+
+/**
+ * @brief Reusable MMe solver.
+ * 
+ * The store and the queues live as long as the solver and take their memory
+ * from its arena. solve() clears them with reset(), which keeps the table
+ * and the buckets allocated for the next instance.
+ * 
+ * In the concurrent mode (see set_concurrent()), each direction has a
+ * worker, a store and a queue of its own. For each value of C, the serial
+ * loop expands the forward nodes with pr_F == C and then the backward ones
+ * with pr_B == C, and neither direction's expansions depend on the other's.
+ * The workers expand both at once and log them, each checks the other's
+ * successors for collisions against its own store, and the log is replayed
+ * in the serial order to find where the serial loop stops.
+ */
+template <class Store>
+class MmeSolver {
+public:
+    typedef typename Store::Domain P;
+    typedef typename Store::State State;
+    typedef typename P::Node Node;
+
+    MmeSolver(int eps, int discount, const HeuristicKinds &kinds);
+    int solve(State initial_state, State goal_state);
+    void reset();
+
+    /**
+     * @brief Gets the counters of the last solve.
+     */
+    const Counters &get_counters() const {
+        return counters_;
+    }
+
+    void set_concurrent(bool concurrent);
+
+private:
+    /** @brief largest number of nodes that a direction expands between two
+     * replays in the concurrent mode */
+    static const std::size_t STEP_POPS = 1024;
+    /** @brief g-value of a state that a direction has not reached */
+    static constexpr int G_NONE = -1;
+
+    /**
+     * @brief Expansion logged by the worker of a direction in the
+     * concurrent mode.
+     */
+    struct Pop {
+        /** @brief fmin_D before the node was popped */
+        int fmin;
+        /** @brief gmin_D before the node was popped */
+        int gmin;
+        /** @brief cheapest solution through a successor of the node that
+         * the other direction had open, or INT_MAX */
+        int best;
+        /** @brief counters of the direction before the expansion */
+        Counters counters;
+    };
+
+    /**
+     * @brief Successor opened by an expansion in the concurrent mode.
+     */
+    struct Opened {
+        State s;
+        std::size_t hash;
+        int g;
+        /** @brief index of the expansion in the direction's log */
+        std::size_t pop;
+    };
+
+    /**
+     * @brief Open flag and g-value of a state in the backward store before
+     * the backward worker changed them for the current value of C.
+     */
+    struct Prior {
+        bool open;
+        int g;
+    };
+
+    /**
+     * @brief Arena, store, queue, log and counters of one direction in the
+     * concurrent mode.
+     */
+    struct Side {
+        Counters counters;
+        Arena arena;
+        Store store;
+        MmeQueue<Store> queue;
+        ArenaVector<Pop> pops;
+        ArenaVector<Opened> opened;
+        StateTable<State, Prior> priors;
+
+        Side(Direction dir, int eps)
+            : arena(counters.arena), store(arena.make<Store>()),
+              queue(arena.make<MmeQueue<Store>>(dir, eps)),
+              pops(arena.make<ArenaVector<Pop>>()),
+              opened(arena.make<ArenaVector<Opened>>()),
+              priors(arena.make<StateTable<State, Prior>>())
+        {}
+    };
+
+    int solve_concurrent(State initial_state, State goal_state);
+    void expand_side(Direction dir, int C, std::size_t max_pops, const typename P::Heuristic &heuristic);
+    void resolve_side(Direction dir);
+
+    int eps_;
+    int discount_;
+    HeuristicKinds kinds_;
+    Counters counters_;
+    Arena arena_;
+    Store store_;
+    MmeQueue<Store> queue_F_;
+    MmeQueue<Store> queue_B_;
+    std::unique_ptr<Side> sides_[2];
+    std::unique_ptr<WorkStealingPool> pool_;
+};
+
 
 /* exported function prototypes */
-int mme(const std::vector<int> &initial_state, const std::vector<int> &goal_state, int eps, int gap_x, int &nodes_expanded);
\ No newline at end of file
+template <class Store>
+int mme(typename Store::State initial_state, typename Store::State goal_state, int eps, int discount, const HeuristicKinds &kinds, Counters &counters);
\ No newline at end of file
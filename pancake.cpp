@@ -1,7 +1,7 @@
 /**
  * @file pancake.cpp
  * @brief Implementation for functions relating to the n-pancake problem.
- * 
+ *
  * @author Andrew Gu (andrewg2)
  * @bug No known bugs.
  */
@@ -9,137 +9,220 @@
 #include "pancake.h"
 
 #include <assert.h>
-#include <limits.h>
 
 /**
  * @brief Prints the contents of the given node.
- * 
+ *
  * The output format looks like:
  * Node:
  * s: ...
  * dir: ...
- * 
+ *
  * @param node Node to print.
  * @return Void.
  */
-void print_node(const Node &node) {
+template <int N>
+void Pancake<N>::print_node(const Node &node) {
     std::cout << "Node:" << std::endl << "s: ";
-    for (int i : node.s) {
-        std::cout << i << " ";
-    }
+    print_state(node.s);
     if (node.dir == Direction::F) {
-        std::cout << "\ndir: F" << std::endl;
+        std::cout << "dir: F" << std::endl;
     } else if (node.dir == Direction::B) {
-        std::cout << "\ndir: B" << std::endl;
+        std::cout << "dir: B" << std::endl;
     }
 }
 
 /**
- * @brief Print the contents of a vector.
- * 
- * @param v Vector to print.
+ * @brief Prints the pancake stack from top to bottom.
+ *
+ * @param s Packed pancake stack.
  * @return Void.
  */
-void print_vector(const std::vector<int> &v) {
-    int v_size = v.size();
-    for (int i = 0; i < v_size; ++i) {
-        std::cout << v[i] << " ";
+template <int N>
+void Pancake<N>::print_state(const State &s) {
+    for (int i = 0; i < N; ++i) {
+        std::cout << static_cast<int>(s.p[i]) << " ";
     }
     std::cout << std::endl;
 }
 
+/**
+ * @brief Packs a pancake stack.
+ *
+ * @param stack Pancakes ordered from top to bottom, without the plate.
+ * @return Packed stack.
+ */
+template <int N>
+typename Pancake<N>::State Pancake<N>::pack(const std::vector<int> &stack) {
+    assert(stack.size() == N);
+    State s {};
+    for (int i = 0; i < N; ++i) {
+        assert(stack[i] >= 0 && stack[i] < N);
+        s.p[i] = stack[i];
+    }
+    return s;
+}
+
 /**
  * @brief Checks if the given state is solved by comparing against the goal
  * state.
- * 
+ *
  * @param s State to check.
  * @param g Goal state.
  * @return True if the state is solved; false otherwise.
  */
-bool is_solved(const std::vector<int> &s, const std::vector<int> &g) {
-    if (s.size() != g.size()) {
-        return false;
-    }
-    int s_size = s.size();
-    for (int i = 0; i < s_size; ++i) {
-        if (s[i] != g[i]) {
-            return false;
-        }
-    }
+template <int N>
+bool Pancake<N>::is_solved(const State &s, const State &g) {
+    return s == g;
+}
+
+/**
+ * @brief Checks if the goal state is reachable from the given state, which
+ * it always is.
+ *
+ * @param s State to check.
+ * @param g Goal state.
+ * @return True.
+ */
+template <int N>
+bool Pancake<N>::is_solvable(__attribute__((unused)) const State &s, __attribute__((unused)) const State &g) {
     return true;
 }
 
 /**
- * @brief Performs a k-flip on the given pancake stack.
- * 
- * @param s Pancake stack ordered from top to bottom.
- * @param k Index to flip.
- * @return Pancake stack after the flip.
- * @pre k is in [1, n - 1] where n is the number of pancakes.
+ * @brief Constructor.
+ *
+ * Labels every pancake with its position in the target stack of each
+ * direction.
+ *
+ * @param is Initial state, the target of the backward direction.
+ * @param gs Goal state, the target of the forward direction.
+ * @param discount x for the GAP-x heuristic.
+ * @param kinds Unused; GAP-x is the only heuristic of the domain.
  */
-std::vector<int> flip(const std::vector<int> &s, int k) {
-    int n = s.size() - 1;
-    assert(k >= 1 && k < n);
-    std::vector<int> s_flip(s.begin(), s.end());
-    int i = 0;
-    int j = k;
-    while (i < j) {
-        std::swap(s_flip[i++], s_flip[j--]);
+template <int N>
+Pancake<N>::Heuristic::Heuristic(const State &is, const State &gs, int discount, __attribute__((unused)) const HeuristicKinds &kinds)
+    : gap_x(discount)
+{
+    for (int dir = Direction::F; dir <= Direction::B; ++dir) {
+        const State &target = (dir == Direction::F) ? gs : is;
+        for (int i = 0; i < N; ++i) {
+            label[dir][target.p[i]] = i;
+        }
+        label[dir][N] = N;
     }
-    return s_flip;
 }
 
 /**
- * @brief Computes the heuristic for the given state and direction.
- * 
- * The current implementation is the GAP-x heuristic for both the forward and
- * backward directions.
- * 
- * @param s Vector representing the pancake stack.
- * @param dir F for forward; B for backward.
- * @param gap_x x for the GAP-x heuristic.
+ * @brief Computes the GAP-x heuristic between the given state and the target
+ * state of the given direction.
+ *
+ * Only roots need this; expand() derives the value of each successor in
+ * O(1).
+ *
+ * @param s Packed pancake stack.
+ * @param dir F for the distance to the goal; B for the distance to the
+ * initial state.
  * @return Heuristic value.
  */
-int h(const std::vector<int> &s, Direction dir, int gap_x) {
-    /* blind heuristic for backward direction */
-    if (dir == Direction::B) {
-        return 0;
-    }
-    int n = s.size() - 1;
-    /* GAP-x heuristic */
+template <int N>
+int Pancake<N>::Heuristic::operator()(const State &s, Direction dir) const {
     int gap = 0;
-    for (int i = gap_x; i < n; ++i) {
-        if (abs(s[i] - s[i+1]) > 1) {
-            gap++;
-        }
+    for (int i = 0; i < N; ++i) {
+        gap += is_gap(dir, s.p[i], get_pancake(s, i + 1));
     }
     return gap;
 }
 
+/**
+ * @brief Makes the node of a search root.
+ *
+ * @param s Packed pancake stack.
+ * @param dir Direction that the node is visited from.
+ * @param heuristic Heuristic of the current solve.
+ * @return Node of s that no flip generated.
+ */
+template <int N>
+typename Pancake<N>::Node Pancake<N>::make_root(const State &s, Direction dir, const Heuristic &heuristic) {
+    return Node(s, get_hash(s), NO_MOVE, dir, heuristic(s, Direction::F), heuristic(s, Direction::B));
+}
+
 /**
  * @brief Expands the given node.
- * 
+ *
+ * A k-flip is its own inverse, so the flip that generated the node only
+ * leads back to its parent and is skipped. The hash and heuristic values of
+ * each successor are derived from those of the given node.
+ *
  * @param node Node representing a state.
- * @param gap_x x for the GAP-x heuristic.
- * @param nodes_expanded (output) Number of nodes expanded so far.
- * @return Vector of all states one k-flip away from the given state.
+ * @param heuristic Heuristic of the current solve.
+ * @param counters (output) Counters of the current solve.
+ * @return Vector of all states one k-flip away from the given state, except
+ * for its parent.
  */
-NodeVector expand(const Node &node, int gap_x, int &nodes_expanded) {
-    nodes_expanded++;
+template <int N>
+typename Pancake<N>::NodeVector Pancake<N>::expand(const Node &node, const Heuristic &heuristic, Counters &counters) {
+    counters.nodes_expanded++;
     NodeVector successors;
-    int n = node.s.size() - 1;
-    if (node.dir == Direction::F) {
-        for (int k = 1; k < n; ++k) {
-            std::vector<int> s_flip = flip(node.s, k);
-            // increment g_F (assumes unit cost)
-            successors.emplace_back(s_flip, Direction::F);
-        }
-    } else if (node.dir == Direction::B) {
-        for (int k = 1; k < n; ++k) {
-            std::vector<int> s_flip = flip(node.s, k);
-            // increment g_B (assumes unit cost)
-            successors.emplace_back(s_flip, Direction::B);
+    successors.reserve(N - 1);
+    for (int k = 1; k < N; ++k) {
+        if (k == node.move) {
+            counters.moves_pruned++;
+            continue;
         }
+        counters.nodes_generated++;
+        successors.emplace_back(flip(node.s, k), get_flip_hash(node.s, node.hash, k), k, node.dir,
+            node.h_F + heuristic.get_delta(Direction::F, node.s, k),
+            node.h_B + heuristic.get_delta(Direction::B, node.s, k));
     }
     return successors;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Makes the k-th move of the node in place, deriving its hash and
+ * heuristic values as expand() does.
+ * 
+ * @param node (in/out) Node to move.
+ * @param k Index of the move, below get_num_moves(node).
+ * @param heuristic Heuristic of the current solve.
+ * @param undo (output) Values that unmake_move() restores.
+ * @return False, leaving the node unchanged, if the flip is the one that
+ * generated the node; true otherwise.
+ */
+template <int N>
+bool Pancake<N>::make_move(Node &node, int k, const Heuristic &heuristic, Undo &undo) {
+    int flip_k = k + 1;
+    if (flip_k == node.move) {
+        return false;
+    }
+    undo = Undo{node.hash, node.move, node.h_F, node.h_B};
+    node.h_F += heuristic.get_delta(Direction::F, node.s, flip_k);
+    node.h_B += heuristic.get_delta(Direction::B, node.s, flip_k);
+    node.hash = get_flip_hash(node.s, node.hash, flip_k);
+    node.s = flip(node.s, flip_k);
+    node.move = flip_k;
+    return true;
+}
+
+/**
+ * @brief Undoes the last move made in place with make_move().
+ * 
+ * A k-flip is its own inverse, so the stack is flipped again.
+ * 
+ * @param node (in/out) Node to move back.
+ * @param undo Values saved by make_move().
+ * @return Void.
+ */
+template <int N>
+void Pancake<N>::unmake_move(Node &node, const Undo &undo) {
+    node.s = flip(node.s, node.move);
+    node.hash = undo.hash;
+    node.move = undo.move;
+    node.h_F = undo.h_F;
+    node.h_B = undo.h_B;
+}
+
+/* explicit instantiations */
+template struct Pancake<8>;
+template struct Pancake<12>;
+template struct Pancake<16>;
@@ -2,7 +2,13 @@
  * @file pancake.h
  * @brief Struct definitions and function prototypes relating to the n-pancake
  * problem.
- * 
+ *
+ * The problem is a template over the number of pancakes, and states are
+ * byte-packed stacks from stack.h, so flips and comparisons use the
+ * vectorized operations when they are built. Nodes carry Zobrist hashes,
+ * which a k-flip updates over the flipped prefix only. Definitions live in
+ * pancake.cpp, which instantiates the stacks used by main.cpp.
+ *
  * @author Andrew Gu (andrewg2)
  * @bug No known bugs.
  */
@@ -10,82 +16,247 @@
 #pragma once
 
 #include <vector>
-#include <unordered_set>
-#include <unordered_map>
-#include <memory>
+#include <array>
 #include <iostream>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+
+#include "domain.h"
+#include "counters.h"
+#include "stack.h"
+
+/** @brief Zobrist table of the N-pancake problem, see Pancake::ZOBRIST */
+template <int N>
+using PancakeZobristTable = std::array<std::array<uint64_t, N>, N>;
 
 /**
- * @brief Forward or backward direction.
+ * @brief Builds the Zobrist table of the N-pancake problem.
+ *
+ * The keys come from splitmix64() run at compile time.
+ *
+ * @return Table mapping (position, pancake) to a random key.
  */
-enum Direction { F, B };
+template <int N>
+constexpr PancakeZobristTable<N> make_pancake_zobrist_table() {
+    PancakeZobristTable<N> table {};
+    uint64_t x = N;
+    for (int i = 0; i < N; ++i) {
+        for (int p = 0; p < N; ++p) {
+            table[i][p] = splitmix64(x);
+        }
+    }
+    return table;
+}
 
 /**
- * @brief Node used in the search algorithm.
- * 
- * A node corresponds to either the forward or backward direction.
+ * @brief The N-pancake problem, a domain as described in domain.h.
  */
-struct Node {
-    /** @brief state representing a pancake stack */
-    std::vector<int> s;
-    /** @brief direction that the node is visited from */
-    Direction dir;
+template <int N>
+struct Pancake {
+    static_assert(N >= 2 && N <= 64, "unsupported number of pancakes");
+
+    /** @brief number of pancakes, which is also the value of the plate */
+    static constexpr int NUM_PANCAKES = N;
+    /** @brief length of an unpacked stack, which leaves out the plate */
+    static constexpr int SIZE = N;
+    /** @brief bytes of a packed stack */
+    static constexpr int CAP = (N + 15) / 16 * 16;
 
     /**
-     * @brief Constructor.
+     * @brief Packed pancake stack.
      */
-    Node(const std::vector<int> &s, Direction dir)
-        : s(s), dir(dir)
-    {}
-};
+    typedef Stack<CAP> State;
+
+    /** @brief k of a node that was not generated by a flip */
+    static constexpr int NO_MOVE = 0;
+
+    /**
+     * @brief ZOBRIST[i][p] is the key of pancake p at position i. The hash
+     * of a stack is the XOR of the keys of its pancakes, so a k-flip only
+     * changes the keys of the flipped prefix.
+     */
+    static constexpr PancakeZobristTable<N> ZOBRIST = make_pancake_zobrist_table<N>();
+
+    /**
+     * @brief Node used in the search algorithm.
+     *
+     * A node corresponds to either the forward or backward direction. It
+     * carries the Zobrist hash of its stack and its heuristic values, which
+     * successors update in place of rescanning the whole stack.
+     */
+    struct Node {
+        /** @brief state representing a pancake stack */
+        State s;
+        /** @brief Zobrist hash of s */
+        std::size_t hash;
+        /** @brief k of the k-flip that generated the node, or NO_MOVE */
+        int move;
+        /** @brief direction that the node is visited from */
+        Direction dir;
+        /** @brief GAP-x estimate of the distance to the goal state */
+        int h_F;
+        /** @brief GAP-x estimate of the distance to the initial state */
+        int h_B;
+
+        /**
+         * @brief Constructor.
+         */
+        Node(const State &s, std::size_t hash, int move, Direction dir, int h_F, int h_B)
+            : s(s), hash(hash), move(move), dir(dir), h_F(h_F), h_B(h_B)
+        {}
+
+        /**
+         * @brief Gets the heuristic value in the given direction.
+         */
+        int get_h(Direction d) const {
+            return (d == Direction::F) ? h_F : h_B;
+        }
+    };
 
-/**
- * @brief Hash function for Node.
- */
-struct NodeHash {
     /**
-     * @brief Hash a node based only on its state s.
+     * @brief GAP-x heuristic in both directions.
+     *
+     * Pancakes are compared by their position in the target stack of each
+     * direction, so the forward direction counts the gaps with respect to
+     * the goal and the backward direction those with respect to the initial
+     * state.
      */
-    std::size_t operator()(const Node &node) const {
-        std::size_t seed = node.s.size();
-        for (int i : node.s) {
-            seed ^= i + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    struct Heuristic {
+        /**
+         * @brief label[dir][p] is the position of pancake p in the target
+         * stack of the direction; the plate is last
+         */
+        uint8_t label[2][N + 1];
+        /** @brief gaps that involve one of the x first pancakes of the target
+         * are not counted */
+        int gap_x;
+
+        Heuristic(const State &is, const State &gs, int discount, const HeuristicKinds &kinds);
+        int operator()(const State &s, Direction dir) const;
+
+        /**
+         * @brief Does nothing; GAP-x keeps no tables shared between solves.
+         */
+        static void prepare(__attribute__((unused)) const State &is, __attribute__((unused)) const State &gs,
+                            __attribute__((unused)) const HeuristicKinds &kinds) {}
+
+        /**
+         * @brief Checks if two adjacent pancakes form a gap counted by GAP-x.
+         *
+         * @param dir Direction whose target stack the pair is compared with.
+         * @param a Upper pancake.
+         * @param b Lower pancake, or the plate.
+         * @return 1 if the pair is a counted gap; 0 otherwise.
+         */
+        int is_gap(Direction dir, int a, int b) const {
+            int la = label[dir][a];
+            int lb = label[dir][b];
+            return (abs(la - lb) > 1 && la >= gap_x && lb >= gap_x) ? 1 : 0;
         }
-        return seed;
+
+        /**
+         * @brief Gets the change in h_D when the stack is k-flipped.
+         *
+         * Reversing the prefix keeps every adjacency inside it, so the only
+         * pair whose gap can change is the one across the flip, which turns
+         * from (s[k], s[k+1]) into (s[0], s[k+1]).
+         */
+        int get_delta(Direction dir, const State &s, int k) const {
+            int below = get_pancake(s, k + 1);
+            return is_gap(dir, s.p[0], below) - is_gap(dir, s.p[k], below);
+        }
+    };
+
+    /* typedef for convenience */
+    typedef ArenaVector<Node> NodeVector;
+
+    /** @brief largest number of moves of a node */
+    static constexpr int MAX_MOVES = N - 1;
+
+    /**
+     * @brief Values of a node that unmake_move() restores besides its
+     * stack, which a second flip restores.
+     */
+    struct Undo {
+        std::size_t hash;
+        int move;
+        int h_F;
+        int h_B;
+    };
+
+    /**
+     * @brief Gets the number of moves of the node, including the one that
+     * undoes its own; move k is the (k + 1)-flip of expand().
+     */
+    static int get_num_moves(const Node &) {
+        return N - 1;
+    }
+
+    /**
+     * @brief Gets the pancake at the given position, or the plate below the
+     * last pancake.
+     */
+    static int get_pancake(const State &s, int i) {
+        return (i < N) ? s.p[i] : N;
+    }
+
+    /**
+     * @brief Gets the name used in experiment file names, e.g. "10pancake".
+     */
+    static std::string get_name() {
+        return std::to_string(N) + "pancake";
     }
-};
 
-/**
- * @brief Equality function for Node.
- */
-struct NodeEqual {
     /**
-     * @brief Two nodes are equal iff their states s are the same.
+     * @brief Computes the Zobrist hash of the stack from scratch.
+     *
+     * Successors derive their hash from their parent's with
+     * get_flip_hash(), so this is only needed for roots.
      */
-    bool operator()(const Node &node1, const Node &node2) const {
-        if (node1.s.size() != node2.s.size()) {
-            return false;
+    static std::size_t get_hash(const State &s) {
+        std::size_t hash = 0;
+        for (int i = 0; i < N; ++i) {
+            hash ^= ZOBRIST[i][s.p[i]];
         }
-        int s_size = node1.s.size();
-        for (int i = 0; i < s_size; ++i) {
-            if (node1.s[i] != node2.s[i]) {
-                return false;
-            }
+        return hash;
+    }
+
+    /**
+     * @brief Gets the Zobrist hash of the k-flip of the stack in O(k), from
+     * the hash of the stack.
+     */
+    static std::size_t get_flip_hash(const State &s, std::size_t hash, int k) {
+        for (int i = 0; i <= k; ++i) {
+            hash ^= ZOBRIST[i][s.p[i]] ^ ZOBRIST[i][s.p[k - i]];
         }
-        return true;
+        return hash;
     }
-};
 
-/* typedef for convenience */
-typedef std::unordered_set<Node,NodeHash,NodeEqual> NodeSet;
-typedef std::unordered_map<Node,int,NodeHash,NodeEqual> NodeIntMap;
-typedef std::vector<Node> NodeVector;
+    /**
+     * @brief Gets the byte that stores keep beside a node's state to rebuild
+     * it; pancake nodes need none.
+     */
+    static uint8_t get_aux(const Node &) {
+        return 0;
+    }
+
+    /**
+     * @brief Rebuilds a node from the values that stores keep.
+     */
+    static Node make_node(const State &s, std::size_t hash, uint8_t, uint8_t move, Direction dir, int h_F, int h_B) {
+        return Node(s, hash, move, dir, h_F, h_B);
+    }
 
-/* exported function prototypes */
-void print_node(const Node &node);
-void print_vector(const std::vector<int> &v);
+    /* exported function prototypes */
+    static void print_node(const Node &node);
+    static void print_state(const State &s);
 
-bool is_solved(const std::vector<int> &s, const std::vector<int> &g);
-std::vector<int> flip(const std::vector<int> &s, int k);
-int h(const std::vector<int> &s, __attribute__((unused)) Direction dir, int gap_x);
-NodeVector expand(const Node &node, int gap_x, int &nodes_expanded);
\ No newline at end of file
+    static State pack(const std::vector<int> &stack);
+    static bool is_solved(const State &s, const State &g);
+    static bool is_solvable(const State &s, const State &g);
+    static Node make_root(const State &s, Direction dir, const Heuristic &heuristic);
+    static NodeVector expand(const Node &node, const Heuristic &heuristic, Counters &counters);
+    static bool make_move(Node &node, int k, const Heuristic &heuristic, Undo &undo);
+    static void unmake_move(Node &node, const Undo &undo);
+};
@@ -0,0 +1,188 @@
+/**
+ * @file pdb.cpp
+ * @brief Construction of the additive pattern databases of the n-puzzle.
+ *
+ * @author Andrew Gu (andrewg2)
+ * @bug No known bugs.
+ */
+
+#include "pdb.h"
+
+#include <assert.h>
+
+/**
+ * @brief Constructor. Builds the database of the given pattern.
+ *
+ * @param squares Mask of the target squares of the pattern tiles; at least
+ * one square must be left out.
+ */
+template <int DIM>
+PatternDatabase<DIM>::PatternDatabase(uint32_t squares)
+    : num_tiles_(0)
+{
+    for (int i = 0; i < NUM_SQUARES; ++i) {
+        if (squares & (1u << i)) {
+            targets_[num_tiles_++] = i;
+        }
+    }
+    assert(num_tiles_ > 0 && num_tiles_ < NUM_SQUARES);
+    uint64_t num_placements = 1;
+    for (int j = num_tiles_ - 1; j >= 0; --j) {
+        place_values_[j] = num_placements;
+        num_placements *= NUM_SQUARES - j;
+    }
+    table_.assign(num_placements * (NUM_SQUARES - num_tiles_), UNSEEN);
+    build();
+}
+
+/**
+ * @brief Gets the databases built so far, by pattern. They live until the
+ * program exits and are shared by every solver.
+ */
+template <int DIM>
+std::map<uint32_t, std::unique_ptr<PatternDatabase<DIM>>> &PatternDatabase<DIM>::get_databases() {
+    static std::map<uint32_t, std::unique_ptr<PatternDatabase>> databases;
+    return databases;
+}
+
+/**
+ * @brief Builds the database of the given pattern unless it exists.
+ *
+ * Databases are not locked, so every database a batch uses must be
+ * prepared before its workers start.
+ *
+ * @param squares Mask of the target squares of the pattern tiles.
+ * @return Void.
+ */
+template <int DIM>
+void PatternDatabase<DIM>::prepare(uint32_t squares) {
+    std::unique_ptr<PatternDatabase> &pdb = get_databases()[squares];
+    if (!pdb) {
+        pdb.reset(new PatternDatabase(squares));
+    }
+}
+
+/**
+ * @brief Gets the database of the given pattern, which must have been
+ * prepared.
+ *
+ * @param squares Mask of the target squares of the pattern tiles.
+ * @return Database of the pattern.
+ */
+template <int DIM>
+const PatternDatabase<DIM> &PatternDatabase<DIM>::get(uint32_t squares) {
+    auto it = get_databases().find(squares);
+    assert(it != get_databases().end());
+    return *it->second;
+}
+
+/**
+ * @brief Gets the patterns that the heuristic splits the board into.
+ *
+ * The 3x3 board is split 4-5 and the 4x4 board 4-6-6, with square 0 in the
+ * smallest pattern. Whichever pattern holds the target square of the blank
+ * is used without it, so the goal state's tiles are split 3-5 and 3-6-6.
+ * Databases of the 5x5 board would not fit in memory, so it has none.
+ *
+ * @return Masks of disjoint patterns that cover the board, or none.
+ */
+template <int DIM>
+std::vector<uint32_t> PatternDatabase<DIM>::get_partition() {
+    if (DIM == 3) {
+        return {0x00f, 0x1f0};  // {0, 1, 2, 3}, {4, ..., 8}
+    } else if (DIM == 4) {
+        return {0x0033, 0x0ccc, 0xf300};  // {0, 1, 4, 5}, {2, 3, 6, 7, 10, 11}, {8, 9, 12, ..., 15}
+    }
+    return {};
+}
+
+/**
+ * @brief Gets the placement of the given index, the inverse of get_index().
+ *
+ * @param index Index of a placement.
+ * @param pos (output) Square of each pattern tile.
+ * @return Void.
+ */
+template <int DIM>
+void PatternDatabase<DIM>::get_placement(uint64_t index, int *pos) const {
+    uint32_t used = 0;
+    for (int j = 0; j < num_tiles_; ++j) {
+        int digit = index / place_values_[j];
+        index %= place_values_[j];
+        /* the square is the digit-th smallest unused square */
+        uint32_t rest = ~used;
+        for (int k = 0; k < digit; ++k) {
+            rest &= rest - 1;
+        }
+        pos[j] = __builtin_ctz(rest);
+        used |= 1u << pos[j];
+    }
+}
+
+/**
+ * @brief Fills the table by a breadth-first search backward from the target
+ * placement.
+ *
+ * A search state is a placement together with the region of the blank.
+ * Moving a pattern tile into the blank's region costs one and leaves the
+ * blank on the tile's old square; the blank moves within its region for
+ * free, so those moves are not searched. Keys of regions named by a square
+ * other than their smallest are never looked up and stay UNSEEN.
+ *
+ * @return Void.
+ */
+template <int DIM>
+void PatternDatabase<DIM>::build() {
+    std::vector<uint64_t> frontier;
+    std::vector<uint64_t> next;  // keys of the states at the next depth
+    auto visit = [&](uint64_t index, uint32_t free, uint32_t region, int depth) {
+        uint64_t key = get_key(index, free, region);
+        if (table_[key] == UNSEEN) {
+            table_[key] = depth;
+            next.push_back(key);
+        }
+    };
+
+    uint32_t free = BOARD;
+    for (int j = 0; j < num_tiles_; ++j) {
+        free &= ~(1u << targets_[j]);
+    }
+    for (uint32_t rest = free; rest != 0; ) {
+        uint32_t region = get_region<DIM>(free, __builtin_ctz(rest));
+        rest &= ~region;
+        visit(get_index(targets_), free, region, 0);
+    }
+
+    int pos[NUM_SQUARES];
+    for (int depth = 0; !next.empty(); ++depth) {
+        frontier.swap(next);
+        next.clear();
+        for (uint64_t key : frontier) {
+            get_placement(key / (NUM_SQUARES - num_tiles_), pos);
+            uint32_t free = BOARD;
+            for (int j = 0; j < num_tiles_; ++j) {
+                free &= ~(1u << pos[j]);
+            }
+            /* the region is named by the rank of its smallest square */
+            uint32_t smallest = free;
+            for (uint64_t k = key % (NUM_SQUARES - num_tiles_); k > 0; --k) {
+                smallest &= smallest - 1;
+            }
+            uint32_t region = get_region<DIM>(free, __builtin_ctz(smallest));
+            for (int j = 0; j < num_tiles_; ++j) {
+                int from = pos[j];
+                for (uint32_t to = NEIGHBOR_MASKS<DIM>[from] & region; to != 0; to &= to - 1) {
+                    pos[j] = __builtin_ctz(to);
+                    uint32_t moved_free = free ^ (1u << from) ^ (1u << pos[j]);
+                    visit(get_index(pos), moved_free, get_region<DIM>(moved_free, from), depth + 1);
+                }
+                pos[j] = from;
+            }
+        }
+    }
+}
+
+/* explicit instantiations */
+template class PatternDatabase<3>;
+template class PatternDatabase<4>;
+template class PatternDatabase<5>;
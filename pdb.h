@@ -0,0 +1,169 @@
+/**
+ * @file pdb.h
+ * @brief Additive pattern databases for the n-puzzle.
+ *
+ * A pattern is a set of squares. Its database holds, for every placement of
+ * the tiles whose target squares are in the pattern, a lower bound on the
+ * number of moves of those tiles needed to bring them all home. Tiles are
+ * named by their target squares, so one database serves any target state,
+ * and the blank may end anywhere. Only moves of pattern tiles are counted,
+ * so the databases of disjoint patterns add up to an admissible heuristic.
+ *
+ * @author Andrew Gu (andrewg2)
+ * @bug No known bugs.
+ */
+
+#pragma once
+
+#include "puzzle.h"
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <cstdint>
+
+/** @brief table of the neighbor masks of a DIM x DIM board */
+template <int DIM>
+using NeighborMaskTable = std::array<uint32_t, DIM * DIM>;
+
+/**
+ * @brief Builds the neighbor masks of a DIM x DIM board.
+ *
+ * @return Table whose i-th entry has the bits of the squares next to
+ * square i set.
+ */
+template <int DIM>
+constexpr NeighborMaskTable<DIM> make_neighbor_masks() {
+    NeighborTable<DIM> neighbors = make_neighbor_table<DIM>();
+    NeighborMaskTable<DIM> masks {};
+    for (int i = 0; i < DIM * DIM; ++i) {
+        for (int move = 0; move < NUM_MOVES; ++move) {
+            if (neighbors[i][move] >= 0) {
+                masks[i] |= 1u << neighbors[i][move];
+            }
+        }
+    }
+    return masks;
+}
+
+/** @brief neighbor masks of a DIM x DIM board */
+template <int DIM>
+constexpr NeighborMaskTable<DIM> NEIGHBOR_MASKS = make_neighbor_masks<DIM>();
+
+/**
+ * @brief Gets the region of free squares that the blank can reach from the
+ * given square without moving a pattern tile.
+ *
+ * @param free Mask of the squares not taken by pattern tiles.
+ * @param blank Square of the blank, which is free.
+ * @return Mask of the region.
+ */
+template <int DIM>
+inline uint32_t get_region(uint32_t free, int blank) {
+    uint32_t region = 1u << blank;
+    uint32_t frontier = region;
+    while (frontier != 0) {
+        int i = __builtin_ctz(frontier);
+        frontier &= frontier - 1;
+        uint32_t reached = NEIGHBOR_MASKS<DIM>[i] & free & ~region;
+        region |= reached;
+        frontier |= reached;
+    }
+    return region;
+}
+
+/**
+ * @brief Pattern database of one pattern of the DIM x DIM n-puzzle.
+ *
+ * The blank moves between the free squares of its region at no cost, so
+ * an entry is kept for every placement of the pattern tiles and every
+ * region of the squares they leave free, named by its smallest square.
+ * Keeping the region rather than the minimum over all regions makes the
+ * heuristic consistent: a move changes the entry of at most one pattern, by
+ * at most one. Entries take one byte each, and a database is built by a
+ * breadth-first search backward from the pattern's target placement.
+ */
+template <int DIM>
+class PatternDatabase {
+public:
+    /** @brief number of squares on the board */
+    static constexpr int NUM_SQUARES = DIM * DIM;
+
+    explicit PatternDatabase(uint32_t squares);
+    static void prepare(uint32_t squares);
+    static const PatternDatabase &get(uint32_t squares);
+    static std::vector<uint32_t> get_partition();
+
+    /**
+     * @brief Gets the number of tiles of the pattern.
+     */
+    int get_num_tiles() const {
+        return num_tiles_;
+    }
+
+    /**
+     * @brief Gets the number of entries.
+     */
+    std::size_t size() const {
+        return table_.size();
+    }
+
+    /**
+     * @brief Gets the entry of a placement and the blank's region.
+     *
+     * @param pos pos[j] is the square of the tile whose target is the j-th
+     * smallest square of the pattern.
+     * @param blank Square of the blank.
+     * @return Lower bound on the moves of the pattern tiles.
+     */
+    int lookup(const int *pos, int blank) const {
+        uint32_t free = BOARD;
+        for (int j = 0; j < num_tiles_; ++j) {
+            free &= ~(1u << pos[j]);
+        }
+        return table_[get_key(get_index(pos), free, get_region<DIM>(free, blank))];
+    }
+
+private:
+    /** @brief mask of every square of the board */
+    static constexpr uint32_t BOARD = (1u << NUM_SQUARES) - 1;
+    /** @brief entry not reached yet */
+    static constexpr uint8_t UNSEEN = UINT8_MAX;
+
+    /**
+     * @brief Gets the index of a placement, the rank of the partial
+     * permutation pos among those of num_tiles_ distinct squares.
+     */
+    uint64_t get_index(const int *pos) const {
+        uint64_t index = 0;
+        uint32_t used = 0;
+        for (int j = 0; j < num_tiles_; ++j) {
+            int digit = pos[j] - __builtin_popcount(used & ((1u << pos[j]) - 1));
+            index += digit * place_values_[j];
+            used |= 1u << pos[j];
+        }
+        return index;
+    }
+
+    /**
+     * @brief Gets the position in the table of the entry of a placement and
+     * one of its regions, which is named by the rank of its smallest square
+     * among the free squares.
+     */
+    uint64_t get_key(uint64_t index, uint32_t free, uint32_t region) const {
+        int smallest = __builtin_ctz(region);
+        return index * (NUM_SQUARES - num_tiles_) + __builtin_popcount(free & ((1u << smallest) - 1));
+    }
+
+    static std::map<uint32_t, std::unique_ptr<PatternDatabase>> &get_databases();
+    void get_placement(uint64_t index, int *pos) const;
+    void build();
+
+    int num_tiles_;
+    /** @brief target square of each pattern tile, in increasing order */
+    int targets_[NUM_SQUARES];
+    /** @brief place_values_[j] is the number of placements of the tiles
+     * after the j-th on the squares left free by the first j + 1 */
+    uint64_t place_values_[NUM_SQUARES];
+    std::vector<uint8_t> table_;
+};
@@ -0,0 +1,217 @@
+/**
+ * @file pool.h
+ * @brief Work-stealing thread pool for batches of independent jobs.
+ *
+ * A batch of jobs numbered [0, num_jobs) is dealt round-robin onto one
+ * deque per worker. Each worker takes jobs from the front of its own deque
+ * and, once it runs dry, steals from the back of the others, so workers
+ * that draw long jobs are relieved by those that draw short ones. No job
+ * creates new jobs, so a worker that finds every deque empty is done with
+ * the batch and goes back to sleep until the next one.
+ *
+ * @author Andrew Gu (andrewg2)
+ * @bug No known bugs.
+ */
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <thread>
+#include <memory>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Pool of worker threads that runs batches of jobs with work
+ * stealing.
+ *
+ * The workers are started once by the constructor and joined by the
+ * destructor. Between batches they sleep on a condition variable, and
+ * run() wakes them by bumping the generation of the batch, so a batch only
+ * pays for a wake-up rather than for starting threads.
+ */
+class WorkStealingPool {
+public:
+    /**
+     * @brief Constructor. Starts every worker but worker 0, which is the
+     * thread that calls run().
+     *
+     * @param num_threads Number of workers, or 0 for one per hardware
+     * thread.
+     */
+    explicit WorkStealingPool(int num_threads)
+        : num_threads_(num_threads), generation_(0), num_busy_(0), stopping_(false), fn_(nullptr)
+    {
+        if (num_threads_ <= 0) {
+            num_threads_ = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (int w = 0; w < num_threads_; ++w) {
+            queues_.emplace_back(new Queue());
+        }
+        for (int w = 1; w < num_threads_; ++w) {
+            threads_.emplace_back(&WorkStealingPool::serve, this, w);
+        }
+    }
+
+    /**
+     * @brief Destructor. Stops and joins the workers.
+     */
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (std::thread &thread : threads_) {
+            thread.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    /**
+     * @brief Gets the number of workers.
+     */
+    int get_num_threads() const {
+        return num_threads_;
+    }
+
+    /**
+     * @brief Runs fn(job, worker) for every job in [0, num_jobs) and waits
+     * for all of them.
+     *
+     * The calling thread is worker 0, and jobs are dealt onto no more
+     * deques than there are jobs, so a batch of a single job runs inline
+     * without waking the other workers. fn may keep per-worker state indexed
+     * by worker, since a worker runs its jobs one at a time.
+     */
+    template <class Fn>
+    void run(std::size_t num_jobs, Fn fn) {
+        int num_workers = static_cast<int>(std::min<std::size_t>(num_threads_, std::max<std::size_t>(num_jobs, 1)));
+        for (std::size_t job = 0; job < num_jobs; ++job) {
+            queues_[job % num_workers]->jobs.push_back(job);
+        }
+        std::function<void(std::size_t, int)> batch_fn(fn);
+        if (num_workers == 1) {
+            work(0, batch_fn);
+            return;
+        }
+
+        /* wake the workers, join in as worker 0 and wait for the rest */
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            fn_ = &batch_fn;
+            num_busy_ = num_threads_ - 1;
+            generation_++;
+        }
+        wake_.notify_all();
+        work(0, batch_fn);
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [&]() {
+            return num_busy_ == 0;
+        });
+        fn_ = nullptr;
+    }
+
+private:
+    /**
+     * @brief Deque of the jobs dealt to one worker.
+     */
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::size_t> jobs;
+    };
+
+    /**
+     * @brief Runs jobs on the given worker until every deque is empty.
+     */
+    void work(int worker, const std::function<void(std::size_t, int)> &fn) {
+        std::size_t job;
+        while (next_job(worker, job)) {
+            fn(job, worker);
+        }
+    }
+
+    /**
+     * @brief Body of a worker thread: waits for each new batch, runs its
+     * share of it and reports back, until the pool is destroyed.
+     *
+     * @param worker Index of the worker.
+     * @return Void.
+     */
+    void serve(int worker) {
+        uint64_t seen = 0;
+        while (true) {
+            const std::function<void(std::size_t, int)> *fn;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&]() {
+                    return stopping_ || generation_ != seen;
+                });
+                if (stopping_) {
+                    return;
+                }
+                seen = generation_;
+                fn = fn_;
+            }
+            work(worker, *fn);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--num_busy_ == 0) {
+                done_.notify_one();
+            }
+        }
+    }
+
+    /**
+     * @brief Takes the next job of the worker, stealing one if its own deque
+     * is empty.
+     *
+     * @param worker Index of the worker.
+     * @param job (output) Job to run.
+     * @return True if a job was taken; false if every deque is empty.
+     */
+    bool next_job(int worker, std::size_t &job) {
+        {
+            Queue &own = *queues_[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.jobs.empty()) {
+                job = own.jobs.front();
+                own.jobs.pop_front();
+                return true;
+            }
+        }
+        for (int i = 1; i < num_threads_; ++i) {
+            Queue &victim = *queues_[(worker + i) % num_threads_];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.jobs.empty()) {
+                job = victim.jobs.back();
+                victim.jobs.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int num_threads_;
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    /** @brief guards the fields below */
+    std::mutex mutex_;
+    /** @brief signals a new batch or the destructor to the workers */
+    std::condition_variable wake_;
+    /** @brief signals run() that the last busy worker is done */
+    std::condition_variable done_;
+    /** @brief number of batches started */
+    uint64_t generation_;
+    /** @brief workers still running their share of the current batch */
+    int num_busy_;
+    bool stopping_;
+    /** @brief job function of the current batch */
+    const std::function<void(std::size_t, int)> *fn_;
+};
@@ -7,20 +7,101 @@
  */
 
 #include "puzzle.h"
+#include "pdb.h"
 
 #include <assert.h>
 
 /**
- * @brief Prints the n-puzzle.
+ * @brief Gets the value of the square at the given index.
+ * 
+ * @param s Packed puzzle state.
+ * @param i Row-major index of the square.
+ * @return Value of square i (0 for the empty square).
+ */
+template <int DIM>
+int Puzzle<DIM>::get_square(State s, int i) {
+    return (s >> (i * SQUARE_BITS)) & SQUARE_MASK;
+}
+
+/**
+ * @brief Computes the Zobrist hash of the given state from scratch.
+ * 
+ * Successors derive their hash from their parent's with get_hash_delta(), so
+ * this is only needed for roots.
+ * 
+ * @param s Packed puzzle state.
+ * @return XOR of the keys of the tiles of s.
+ */
+template <int DIM>
+std::size_t Puzzle<DIM>::get_hash(State s) {
+    std::size_t hash = 0;
+    for (int i = 0; i < NUM_SQUARES; ++i) {
+        hash ^= ZOBRIST[i][get_square(s, i)];
+    }
+    return hash;
+}
+
+/**
+ * @brief Computes the square of every tile of the given state from scratch.
+ * 
+ * Successors derive theirs from their parent's with get_pos_delta(), so this
+ * is only needed for roots and for nodes rebuilt from a store.
+ * 
+ * @param s Packed puzzle state.
+ * @return State whose square t holds the index of the square of tile t.
+ */
+template <int DIM>
+typename Puzzle<DIM>::State Puzzle<DIM>::get_tile_squares(State s) {
+    State pos = 0;
+    for (int i = 0; i < NUM_SQUARES; ++i) {
+        pos |= static_cast<State>(i) << (get_square(s, i) * SQUARE_BITS);
+    }
+    return pos;
+}
+
+/**
+ * @brief Packs a row-major board into a State.
  * 
  * @param puzzle Row-major representation of the n-puzzle.
+ * @return Packed state.
+ */
+template <int DIM>
+typename Puzzle<DIM>::State Puzzle<DIM>::pack(const std::vector<int> &puzzle) {
+    assert(puzzle.size() == NUM_SQUARES);
+    State s = 0;
+    for (int i = 0; i < NUM_SQUARES; ++i) {
+        assert(puzzle[i] >= 0 && (State) puzzle[i] <= SQUARE_MASK);
+        s |= (State) puzzle[i] << (i * SQUARE_BITS);
+    }
+    return s;
+}
+
+/**
+ * @brief Unpacks a State into a row-major board.
+ * 
+ * @param s Packed puzzle state.
+ * @return Row-major representation of the n-puzzle.
+ */
+template <int DIM>
+std::vector<int> Puzzle<DIM>::unpack(State s) {
+    std::vector<int> puzzle(NUM_SQUARES);
+    for (int i = 0; i < NUM_SQUARES; ++i) {
+        puzzle[i] = get_square(s, i);
+    }
+    return puzzle;
+}
+
+/**
+ * @brief Prints the n-puzzle.
+ * 
+ * @param puzzle Packed representation of the n-puzzle.
  * @return Void.
  */
-void print_puzzle(const std::vector<int> &puzzle) {
-    assert(puzzle.size() == BOARD_DIM * BOARD_DIM);
-    for (int i = 0; i < BOARD_DIM; ++i) {
-        for (int j = 0; j < BOARD_DIM; ++j) {
-            std::cout << puzzle[i * BOARD_DIM + j] << " ";
+template <int DIM>
+void Puzzle<DIM>::print_state(State puzzle) {
+    for (int i = 0; i < DIM; ++i) {
+        for (int j = 0; j < DIM; ++j) {
+            std::cout << get_square(puzzle, row_col_to_index(i, j)) << " ";
         }
         std::cout << std::endl;
     }
@@ -37,9 +118,10 @@ void print_puzzle(const std::vector<int> &puzzle) {
  * @param node Node to print.
  * @return Void.
  */
-void print_node(const Node &node) {
+template <int DIM>
+void Puzzle<DIM>::print_node(const Node &node) {
     std::cout << "Node:" << std::endl << "s: ";
-    print_puzzle(node.s);
+    print_state(node.s);
     if (node.dir == Direction::F) {
         std::cout << "\ndir: F" << std::endl;
     } else if (node.dir == Direction::B) {
@@ -55,50 +137,9 @@ void print_node(const Node &node) {
  * @param g Goal state to check against.
  * @return True if the puzzle matches the goal; false otherwise.
  */
-bool is_solved(const std::vector<int> &s, const std::vector<int> &g) {
-    assert(s.size() == g.size());
-    int s_size = s.size();
-    assert(s_size == BOARD_DIM * BOARD_DIM);
-    for (int i = 0; i < s_size; ++i) {
-        if (s[i] != g[i]) {
-            return false;
-        }
-    }
-    return true;
-}
-
-/**
- * @brief Gets the row corresponding to the given index based on the board
- * dimension.
- * 
- * @param i Index.
- * @return Row corresponding to i.
- */
-int inline index_to_row(int i) {
-    return i / BOARD_DIM;
-}
-
-/**
- * @brief Gets the column corresponding to the given index based on the board
- * dimension.
- * 
- * @param i Index.
- * @return Column corresponding to i.
- */
-int inline index_to_col(int i) {
-    return i % BOARD_DIM;
-}
-
-/**
- * @brief Gets the index corresponding to the given row and column based on
- * the board dimension.
- * 
- * @param row Row.
- * @param col Column.
- * @return Index corresponding to (row, col).
- */
-int inline row_col_to_index(int row, int col) {
-    return row * BOARD_DIM + col;
+template <int DIM>
+bool Puzzle<DIM>::is_solved(State s, State g) {
+    return s == g;
 }
 
 /**
@@ -106,15 +147,16 @@ int inline row_col_to_index(int row, int col) {
  * 
  * @param s Puzzle state.
  * @param val Value to look for.
- * @param row (output) Row of the empty square.
- * @param col (output) Column of the empty square.
+ * @param row (output) Row of the empty square, or -1 on failure.
+ * @param col (output) Column of the empty square, or -1 on failure.
  * @return True on success; false on failure.
  */
-bool get_pos(const std::vector<int> &s, int val, int &row, int &col) {
-    int s_size = s.size();
-    assert(s_size == BOARD_DIM * BOARD_DIM);
-    for (int i = 0; i < s_size; ++i) {
-        if (s[i] == val) {
+template <int DIM>
+bool Puzzle<DIM>::get_pos(State s, int val, int &row, int &col) {
+    row = -1;
+    col = -1;
+    for (int i = 0; i < NUM_SQUARES; ++i) {
+        if (get_square(s, i) == val) {
             row = index_to_row(i);
             col = index_to_col(i);
             return true;
@@ -124,43 +166,48 @@ bool get_pos(const std::vector<int> &s, int val, int &row, int &col) {
 }
 
 /**
- * @brief Checks if 'up' is a valid move.
+ * @brief Gets the index of the empty square.
  * 
- * @param row Row of the empty square.
- * @return True if 'up' is a valid move; false otherwise.
+ * @param s Puzzle state.
+ * @return Index of the empty square.
  */
-bool is_valid_up(int row) {
-    return row > 0;
+template <int DIM>
+int Puzzle<DIM>::get_blank(State s) {
+    int row, col;
+    get_pos(s, 0, row, col);
+    return row_col_to_index(row, col);
 }
 
 /**
- * @brief Checks if 'down' is a valid move.
+ * @brief Makes the node of a search root.
  * 
- * @param row Row of the empty square.
- * @return True if 'down' is a valid move; false otherwise.
- */
-bool is_valid_down(int row) {
-    return row < BOARD_DIM - 1;
-}
-
-/**
- * @brief Checks if 'left' is a valid move.
+ * The heuristic values are computed from scratch in both directions; every
+ * other node derives its values from its parent's.
  * 
- * @param col Column of the empty square.
- * @return True if 'left' is a valid move; false otherwise.
+ * @param s Puzzle state.
+ * @param dir Direction that the node is visited from.
+ * @param heuristic Heuristic of the current solve.
+ * @return Node of s that no move generated.
  */
-bool is_valid_left(int col) {
-    return col > 0;
+template <int DIM>
+typename Puzzle<DIM>::Node Puzzle<DIM>::make_root(State s, Direction dir, const Heuristic &heuristic) {
+    return Node(s, get_tile_squares(s), get_hash(s), get_blank(s), Move::NoMove, dir, heuristic(s, Direction::F), heuristic(s, Direction::B));
 }
 
 /**
- * @brief Checks if 'left' is a valid move.
+ * @brief Swaps the empty square with the square at the given index.
  * 
- * @param col Column of the empty square.
- * @return True if 'left' is a valid move; false otherwise.
+ * @param s Puzzle state.
+ * @param blank Index of the empty square.
+ * @param to Index of a square adjacent to the empty square.
+ * @return Puzzle state after the swap.
  */
-bool is_valid_right(int col) {
-    return col < BOARD_DIM - 1;
+template <int DIM>
+typename Puzzle<DIM>::State Puzzle<DIM>::swap_blank(State s, int blank, int to) {
+    /* the empty square holds 0, so moving the tile is a clear and a set */
+    State tile = get_square(s, to);
+    s &= ~(SQUARE_MASK << (to * SQUARE_BITS));
+    return s | (tile << (blank * SQUARE_BITS));
 }
 
 /**
@@ -168,36 +215,14 @@ bool is_valid_right(int col) {
  * 
  * @param s Puzzle state.
  * @param move Up, down, left, or right.
- * @return Vector representing the puzzle state after the move.
+ * @return Puzzle state after the move.
  */
-std::vector<int> make_move(const std::vector<int> &s, Move move) {
-    int row, col;
-    get_pos(s, 0, row, col);
-    int index = row_col_to_index(row, col);
-    int swap_index = index;
-    std::vector<int> s_copy(s.begin(), s.end());
-    switch (move) {
-        case Move::Up:
-            assert(is_valid_up(row));
-            swap_index = row_col_to_index(row - 1, col);
-            break;
-        case Move::Down:
-            assert(is_valid_down(row));
-            swap_index = row_col_to_index(row + 1, col);
-            break;
-        case Move::Left:
-            assert(is_valid_left(col));
-            swap_index = row_col_to_index(row, col - 1);
-            break;
-        case Move::Right:
-            assert(is_valid_right(col));
-            swap_index = row_col_to_index(row, col + 1);
-            break;
-        default:
-            throw std::runtime_error("invalid move type");
-    }
-    std::swap(s_copy[index], s_copy[swap_index]);
-    return s_copy;
+template <int DIM>
+typename Puzzle<DIM>::State Puzzle<DIM>::make_move(State s, Move move) {
+    int blank = get_blank(s);
+    int swap_index = NEIGHBORS[blank][move];
+    assert(swap_index >= 0);
+    return swap_blank(s, blank, swap_index);
 }
 
 /**
@@ -214,25 +239,142 @@ int inline get_l1_dist(int s_row, int s_col, int g_row, int g_col) {
 }
 
 /**
- * @brief Computes the Manhattan distance between the given state and goal
- * state.
+ * @brief Builds the pattern databases that the heuristic of an instance
+ * uses, so that heuristics built on other threads only read them.
+ *
+ * @param is Initial state, the target of the backward direction.
+ * @param gs Goal state, the target of the forward direction.
+ * @param kinds Manhattan distance or additive pattern databases in each
+ * direction.
+ * @return Void.
+ */
+template <int DIM>
+void Puzzle<DIM>::Heuristic::prepare(State is, State gs, const HeuristicKinds &kinds) {
+    for (int dir = Direction::F; dir <= Direction::B; ++dir) {
+        if (kinds[dir] != TileHeuristic::AdditivePdb) {
+            continue;
+        }
+        State target = (dir == Direction::F) ? gs : is;
+        int blank = 0;
+        while (get_square(target, blank) != 0) {
+            blank++;
+        }
+        for (uint32_t squares : PatternDatabase<DIM>::get_partition()) {
+            PatternDatabase<DIM>::prepare(squares & ~(1u << blank));
+        }
+    }
+}
+
+/**
+ * @brief Constructor.
+ * 
+ * Locates every tile in the initial and goal states once and tabulates its
+ * Manhattan distance from every square. A direction with pattern databases
+ * takes the patterns of the partition without the target square of its
+ * blank, whose databases must have been built by prepare().
+ * 
+ * @param is Initial state, the target of the backward direction.
+ * @param gs Goal state, the target of the forward direction.
+ * @param discount Normal h is multiplied by 1 / discount. Only Manhattan
+ * distance is discounted.
+ * @param kinds Manhattan distance or additive pattern databases in each
+ * direction. Pattern databases are only used on boards that have a
+ * partition, see PatternDatabase::get_partition().
+ */
+template <int DIM>
+Puzzle<DIM>::Heuristic::Heuristic(State is, State gs, int discount, const HeuristicKinds &kinds) {
+    std::vector<uint32_t> partition = PatternDatabase<DIM>::get_partition();
+    for (int dir = Direction::F; dir <= Direction::B; ++dir) {
+        State target = (dir == Direction::F) ? gs : is;
+        for (int i = 0; i < NUM_SQUARES; ++i) {
+            int tile = get_square(target, i);
+            target_row[dir][tile] = index_to_row(i);
+            target_col[dir][tile] = index_to_col(i);
+            pattern_of[dir][tile] = -1;
+            label_of[dir][tile] = -1;
+        }
+
+        num_patterns[dir] = 0;
+        if (kinds[dir] == TileHeuristic::AdditivePdb) {
+            assert(partition.size() <= MAX_PATTERNS);
+            int blank = row_col_to_index(target_row[dir][0], target_col[dir][0]);
+            for (uint32_t squares : partition) {
+                squares &= ~(1u << blank);
+                Pattern &pattern = patterns[dir][num_patterns[dir]];
+                pattern.pdb = &PatternDatabase<DIM>::get(squares);
+                pattern.num_tiles = 0;
+                for (int i = 0; i < NUM_SQUARES; ++i) {
+                    if (squares & (1u << i)) {
+                        int tile = get_square(target, i);
+                        pattern_of[dir][tile] = num_patterns[dir];
+                        label_of[dir][tile] = pattern.num_tiles;
+                        pattern.tiles[pattern.num_tiles++] = tile;
+                    }
+                }
+                num_patterns[dir]++;
+            }
+        }
+
+        for (int tile = 0; tile < NUM_SQUARES; ++tile) {
+            bool discounted = tile < std::max(1, discount) || pattern_of[dir][tile] >= 0;
+            for (int i = 0; i < NUM_SQUARES; ++i) {
+                dist[dir][tile][i] = discounted ? 0 : get_l1_dist(index_to_row(i), index_to_col(i), target_row[dir][tile], target_col[dir][tile]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Gets the change in the pattern database entry of the tile's pattern
+ * when the tile moves between the given squares.
+ * 
+ * Only the squares of the pattern's tiles are read from pos, so the cost
+ * does not grow with the board.
+ * 
+ * @param dir Direction.
+ * @param pos Square of every tile before the move, see Node::pos.
+ * @param tile Tile that moves, which is in a pattern of dir.
+ * @param from Square of the tile before the move.
+ * @param to Square that the tile moves to.
+ * @return Change in h_D.
+ */
+template <int DIM>
+int Puzzle<DIM>::Heuristic::get_pattern_delta(Direction dir, State pos, int tile, int from, int to) const {
+    const Pattern &pattern = patterns[dir][pattern_of[dir][tile]];
+    int squares[NUM_SQUARES];
+    for (int j = 0; j < pattern.num_tiles; ++j) {
+        squares[j] = get_square(pos, pattern.tiles[j]);
+    }
+    int before = pattern.pdb->lookup(squares, to);  // the blank is on the square the tile moves to
+    squares[label_of[dir][tile]] = to;
+    return pattern.pdb->lookup(squares, from) - before;
+}
+
+/**
+ * @brief Computes the heuristic value of the given state in the given
+ * direction from scratch.
  * 
  * @param s Puzzle state.
- * @param g Goal state.
- * @param discount Normal h is multiplied by 1 / discount.
+ * @param dir F for the distance to the goal; B for the distance to the
+ * initial state.
  * @return Heuristic value.
  */
-int h(const std::vector<int> &s, const std::vector<int> &g, int discount) {
-    assert(s.size() == g.size());
-    assert(s.size() == BOARD_DIM * BOARD_DIM);
-    int s_size = s.size();
-    /* brute force */
+template <int DIM>
+int Puzzle<DIM>::Heuristic::operator()(State s, Direction dir) const {
     int h = 0;
-    for (int i = std::max(1, discount); i < s_size; ++i) {
-        int s_row, s_col, g_row, g_col;
-        get_pos(s, i, s_row, s_col);
-        get_pos(g, i, g_row, g_col);
-        h += get_l1_dist(s_row, s_col, g_row, g_col);
+    int blank = 0;
+    int pos[MAX_PATTERNS][NUM_SQUARES];
+    for (int i = 0; i < NUM_SQUARES; ++i) {
+        int tile = get_square(s, i);
+        h += dist[dir][tile][i];
+        if (tile == 0) {
+            blank = i;
+        } else if (pattern_of[dir][tile] >= 0) {
+            pos[pattern_of[dir][tile]][label_of[dir][tile]] = i;
+        }
+    }
+    for (int p = 0; p < num_patterns[dir]; ++p) {
+        h += patterns[dir][p].pdb->lookup(pos[p], blank);
     }
     return h;
 }
@@ -240,45 +382,135 @@ int h(const std::vector<int> &s, const std::vector<int> &g, int discount) {
 /**
  * @brief Expands the given node and returns its successors.
  * 
+ * The valid moves are read from BLANK_MOVES at the node's empty square, and
+ * the heuristic values of each successor are derived from those of the
+ * given node, so neither the empty square nor h is searched for. The move
+ * that undoes the node's own move only leads back to its parent, so it is
+ * skipped.
+ * 
  * @param node Node to expand.
- * @param nodes_expanded (output) Number of nodes expanded so far.
+ * @param heuristic Heuristic of the current solve.
+ * @param counters (output) Counters of the current solve.
  * @return Vector of successor nodes.
  */
-NodeVector expand(const Node &node, int &nodes_expanded) {
-    nodes_expanded++;
-    int row, col;
-    get_pos(node.s, 0, row, col);
+template <int DIM>
+typename Puzzle<DIM>::NodeVector Puzzle<DIM>::expand(const Node &node, const Heuristic &heuristic, Counters &counters) {
+    counters.nodes_expanded++;
+    const MoveList &valid = BLANK_MOVES[node.blank];
     NodeVector successors;
-    if (is_valid_up(row)) {
-        successors.emplace_back(make_move(node.s, Move::Up), node.dir);
-    }
-    if (is_valid_down(row)) {
-        successors.emplace_back(make_move(node.s, Move::Down), node.dir);
-    }
-    if (is_valid_left(col)) {
-        successors.emplace_back(make_move(node.s, Move::Left), node.dir);
-    }
-    if (is_valid_right(col)) {
-        successors.emplace_back(make_move(node.s, Move::Right), node.dir);
+    successors.reserve(valid.size);
+    for (int k = 0; k < valid.size; ++k) {
+        Move move = valid.moves[k];
+        if (node.move != Move::NoMove && move == get_inverse(node.move)) {
+            counters.moves_pruned++;
+            continue;
+        }
+        int to = valid.to[k];
+        int tile = get_square(node.s, to);
+        counters.nodes_generated++;
+        successors.emplace_back(swap_blank(node.s, node.blank, to), node.pos ^ get_pos_delta(tile, to, node.blank),
+            node.hash ^ get_hash_delta(tile, to, node.blank), to, move, node.dir,
+            node.h_F + heuristic.get_delta(Direction::F, node.pos, tile, to, node.blank),
+            node.h_B + heuristic.get_delta(Direction::B, node.pos, tile, to, node.blank));
     }
     return successors;
 }
 
+/**
+ * @brief Makes the k-th move of the node in place, deriving its hash and
+ * heuristic values as expand() does.
+ * 
+ * @param node (in/out) Node to move.
+ * @param k Index of the move, below get_num_moves(node).
+ * @param heuristic Heuristic of the current solve.
+ * @param undo (output) Values that unmake_move() restores.
+ * @return False, leaving the node unchanged, if the move undoes the node's
+ * own move; true otherwise.
+ */
+template <int DIM>
+bool Puzzle<DIM>::make_move(Node &node, int k, const Heuristic &heuristic, Undo &undo) {
+    const MoveList &valid = BLANK_MOVES[node.blank];
+    Move move = valid.moves[k];
+    if (node.move != Move::NoMove && move == get_inverse(node.move)) {
+        return false;
+    }
+    int to = valid.to[k];
+    int tile = get_square(node.s, to);
+    undo = Undo{node.pos, node.hash, node.blank, node.move, node.h_F, node.h_B};
+    node.h_F += heuristic.get_delta(Direction::F, node.pos, tile, to, node.blank);
+    node.h_B += heuristic.get_delta(Direction::B, node.pos, tile, to, node.blank);
+    node.s = swap_blank(node.s, node.blank, to);
+    node.pos ^= get_pos_delta(tile, to, node.blank);
+    node.hash ^= get_hash_delta(tile, to, node.blank);
+    node.blank = to;
+    node.move = move;
+    return true;
+}
+
+/**
+ * @brief Undoes the last move made in place with make_move().
+ * 
+ * @param node (in/out) Node to move back.
+ * @param undo Values saved by make_move().
+ * @return Void.
+ */
+template <int DIM>
+void Puzzle<DIM>::unmake_move(Node &node, const Undo &undo) {
+    node.s = swap_blank(node.s, node.blank, undo.blank);
+    node.pos = undo.pos;
+    node.hash = undo.hash;
+    node.blank = undo.blank;
+    node.move = undo.move;
+    node.h_F = undo.h_F;
+    node.h_B = undo.h_B;
+}
+
 /**
  * @brief Gets the number of inversions in the given state.
  * 
+ * The empty square is not counted.
  * 
  * @param s Puzzle state.
  * @return Number of inversions.
  */
-int get_num_inversions(const std::vector<int> &s) {
+template <int DIM>
+int Puzzle<DIM>::get_num_inversions(State s) {
     int num_inversions = 0;
-    for (int i = 0; i < BOARD_DIM * BOARD_DIM - 1; ++i) {
-        for (int j = i + 1; j < BOARD_DIM * BOARD_DIM; ++j) {
-            if (s[i] != 0 && s[j] != 0 && s[i] > s[j]) {
+    for (int i = 0; i < NUM_SQUARES - 1; ++i) {
+        for (int j = i + 1; j < NUM_SQUARES; ++j) {
+            int s_i = get_square(s, i);
+            int s_j = get_square(s, j);
+            if (s_i != 0 && s_j != 0 && s_i > s_j) {
                 num_inversions++;
             }
         }
     }
     return num_inversions;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Checks if the goal state is reachable from the given state.
+ * 
+ * On boards of odd width, moves preserve the parity of the number of
+ * inversions. On boards of even width, a vertical move changes it by an odd
+ * amount, so the parity of the inversions plus the row of the empty square
+ * is preserved instead.
+ * 
+ * @param s Puzzle state.
+ * @param g Goal state.
+ * @return True if g is reachable from s; false otherwise.
+ */
+template <int DIM>
+bool Puzzle<DIM>::is_solvable(State s, State g) {
+    int s_row, s_col, g_row, g_col;
+    get_pos(s, 0, s_row, s_col);
+    get_pos(g, 0, g_row, g_col);
+    int s_invariant = get_num_inversions(s) + ((DIM % 2 == 0) ? s_row : 0);
+    int g_invariant = get_num_inversions(g) + ((DIM % 2 == 0) ? g_row : 0);
+    return s_invariant % 2 == g_invariant % 2;
+}
+
+/* explicit instantiations */
+template struct Puzzle<3>;
+template struct Puzzle<4>;
+template struct Puzzle<5>;
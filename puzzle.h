@@ -3,6 +3,10 @@
  * @brief Struct definitions and function prototypes pertaining to the
  * n-puzzle problem.
  * 
+ * The puzzle is a template over the board dimension, so every size gets its
+ * own State type and loops with compile-time bounds. Definitions live in
+ * puzzle.cpp, which instantiates the 3x3, 4x4 and 5x5 boards.
+ * 
  * @author Andrew Gu (andrewg2)
  * @bug No known bugs.
  */
@@ -10,96 +14,447 @@
 #pragma once
 
 #include <vector>
-#include <unordered_set>
-#include <unordered_map>
+#include <array>
 #include <memory>
 #include <iostream>
+#include <cstdint>
+#include <string>
+#include <type_traits>
 
-#define BOARD_DIM (3)
+#include "domain.h"
+#include "counters.h"
 
 /**
- * @brief Forward or backward direction.
+ * @brief n-puzzle move.
+ * 
+ * The move names the direction in which the empty square travels. NoMove
+ * marks a node that was not generated by a move.
  */
-enum Direction { F, B };
+enum Move { Up, Down, Left, Right, NoMove };
+
+template <int DIM>
+class PatternDatabase;
+
+/** @brief number of moves */
+#define NUM_MOVES (4)
 
 /**
- * @brief n-puzzle move.
+ * @brief Gets the move that undoes the given move.
+ * 
+ * @param move Up, down, left, or right.
+ * @return Down, up, right, or left respectively.
+ */
+constexpr Move get_inverse(Move move) {
+    return static_cast<Move>(move ^ 1);
+}
+
+/** @brief 128-bit unsigned integer for boards that do not fit in a word */
+typedef unsigned __int128 uint128_t;
+
+/**
+ * @brief Hashes a packed state.
+ *
+ * Uses the 64-bit finalizer from MurmurHash3 so that boards differing in a
+ * single square spread across the whole word.
+ *
+ * @param s Packed state.
+ * @return Hash value.
+ */
+inline std::size_t hash_state(uint64_t s) {
+    s ^= s >> 33;
+    s *= 0xff51afd7ed558ccdULL;
+    s ^= s >> 33;
+    s *= 0xc4ceb9fe1a85ec53ULL;
+    s ^= s >> 33;
+    return s;
+}
+
+/**
+ * @brief Hashes a packed state that spans two words.
+ *
+ * @param s Packed state.
+ * @return Hash value.
  */
-enum Move { Up, Down, Left, Right };
+inline std::size_t hash_state(uint128_t s) {
+    return hash_state((uint64_t) s ^ hash_state((uint64_t) (s >> 64)));
+}
+
+/** @brief Zobrist table of a DIM x DIM board, see Puzzle::ZOBRIST */
+template <int DIM>
+using ZobristTable = std::array<std::array<uint64_t, DIM * DIM>, DIM * DIM>;
 
 /**
- * @brief Node used in the search algorithm.
+ * @brief Builds the Zobrist table of a DIM x DIM board.
+ * 
+ * The empty square gets a key of 0 everywhere: its position is implied by
+ * those of the tiles, and a move then only changes the key of the one tile
+ * that slides.
  * 
- * A node corresponds to either the forward or backward direction.
+ * @return Table mapping (square, tile) to a random key.
  */
-struct Node {
-    /** @brief state representing a pancake stack */
-    std::vector<int> s;
-    /** @brief direction that the node is visited from */
-    Direction dir;
+template <int DIM>
+constexpr ZobristTable<DIM> make_zobrist_table() {
+    ZobristTable<DIM> table {};
+    uint64_t x = DIM;
+    for (int i = 0; i < DIM * DIM; ++i) {
+        for (int tile = 1; tile < DIM * DIM; ++tile) {
+            table[i][tile] = splitmix64(x);
+        }
+    }
+    return table;
+}
 
-    /**
-     * @brief Constructor.
-     */
-    Node(const std::vector<int> &s, Direction dir)
-        : s(s), dir(dir)
-    {}
+/** @brief neighbor table of a DIM x DIM board, see Puzzle::NEIGHBORS */
+template <int DIM>
+using NeighborTable = std::array<std::array<int, NUM_MOVES>, DIM * DIM>;
+
+/**
+ * @brief Builds the neighbor table of a DIM x DIM board.
+ * 
+ * @return Table mapping (index of the empty square, move) to the index of
+ * the square it swaps with, or -1 if the move is invalid.
+ */
+template <int DIM>
+constexpr NeighborTable<DIM> make_neighbor_table() {
+    NeighborTable<DIM> table {};
+    for (int i = 0; i < DIM * DIM; ++i) {
+        int row = i / DIM;
+        int col = i % DIM;
+        table[i][Move::Up] = (row > 0) ? i - DIM : -1;
+        table[i][Move::Down] = (row < DIM - 1) ? i + DIM : -1;
+        table[i][Move::Left] = (col > 0) ? i - 1 : -1;
+        table[i][Move::Right] = (col < DIM - 1) ? i + 1 : -1;
+    }
+    return table;
+}
+
+/**
+ * @brief Valid moves of the empty square at one index.
+ */
+struct MoveList {
+    /** @brief number of valid moves */
+    int size;
+    /** @brief valid moves */
+    Move moves[NUM_MOVES];
+    /** @brief index of the square that the empty square swaps with */
+    int to[NUM_MOVES];
 };
 
+/** @brief move table of a DIM x DIM board, see Puzzle::BLANK_MOVES */
+template <int DIM>
+using MoveTable = std::array<MoveList, DIM * DIM>;
+
 /**
- * @brief Hash function for Node.
+ * @brief Builds the move table of a DIM x DIM board.
+ * 
+ * @return Table mapping the index of the empty square to its valid moves.
  */
-struct NodeHash {
-    /**
-     * @brief Hash a node based only on its state s.
-     */
-    std::size_t operator()(const Node &node) const {
-        std::size_t seed = node.s.size();
-        for (int i : node.s) {
-            seed ^= i + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+template <int DIM>
+constexpr MoveTable<DIM> make_move_table() {
+    NeighborTable<DIM> neighbors = make_neighbor_table<DIM>();
+    MoveTable<DIM> table {};
+    for (int i = 0; i < DIM * DIM; ++i) {
+        for (int move = 0; move < NUM_MOVES; ++move) {
+            if (neighbors[i][move] >= 0) {
+                MoveList &list = table[i];
+                list.moves[list.size] = static_cast<Move>(move);
+                list.to[list.size] = neighbors[i][move];
+                list.size++;
+            }
         }
-        return seed;
     }
-};
+    return table;
+}
 
 /**
- * @brief Equality function for Node.
+ * @brief The DIM x DIM n-puzzle, a domain as described in domain.h.
  */
-struct NodeEqual {
+template <int DIM>
+struct Puzzle {
+    static_assert(DIM >= 2 && DIM <= 5, "unsupported board dimension");
+
+    /** @brief number of squares on the board */
+    static constexpr int NUM_SQUARES = DIM * DIM;
+    /** @brief length of a row-major board */
+    static constexpr int SIZE = NUM_SQUARES;
+    /** @brief number of bits used by one square of a packed state */
+    static constexpr int SQUARE_BITS = (NUM_SQUARES <= 16) ? 4 : 5;
+
+    /**
+     * @brief Packed n-puzzle state.
+     *
+     * Square i of the row-major board occupies bits [SQUARE_BITS * i,
+     * SQUARE_BITS * (i + 1)), so a 3x3 or 4x4 board fits in a single word and
+     * a 5x5 board in two.
+     */
+    typedef typename std::conditional<NUM_SQUARES * SQUARE_BITS <= 64, uint64_t, uint128_t>::type State;
+
+    /** @brief mask of a single square of a packed state */
+    static constexpr State SQUARE_MASK = (1 << SQUARE_BITS) - 1;
+
+    /**
+     * @brief NEIGHBORS[i][move] is the index of the square that the empty
+     * square at index i swaps with under the move, or -1 if the move is
+     * invalid.
+     */
+    static constexpr NeighborTable<DIM> NEIGHBORS = make_neighbor_table<DIM>();
+
+    /**
+     * @brief BLANK_MOVES[i] lists the valid moves of the empty square at
+     * index i, so successors are generated without any bounds checks.
+     */
+    static constexpr MoveTable<DIM> BLANK_MOVES = make_move_table<DIM>();
+
+    /**
+     * @brief ZOBRIST[i][tile] is the key of the tile on square i. The hash
+     * of a state is the XOR of the keys of its tiles.
+     */
+    static constexpr ZobristTable<DIM> ZOBRIST = make_zobrist_table<DIM>();
+
+    /** @brief move of a node that was not generated by a move */
+    static constexpr Move NO_MOVE = Move::NoMove;
+
+    /**
+     * @brief Node used in the search algorithm.
+     * 
+     * A node corresponds to either the forward or backward direction. It
+     * carries the Zobrist hash of its state, the square of every tile, the
+     * index of its empty square and its heuristic values in both directions
+     * so that successors can derive theirs incrementally.
+     */
+    struct Node {
+        /** @brief packed state representing a puzzle board */
+        State s;
+        /** @brief square of every tile, packed as s with tiles and squares
+         * swapped; see get_tile_squares() */
+        State pos;
+        /** @brief Zobrist hash of s */
+        std::size_t hash;
+        /** @brief index of the empty square */
+        int blank;
+        /** @brief move that generated the node from its parent */
+        Move move;
+        /** @brief direction that the node is visited from */
+        Direction dir;
+        /** @brief heuristic estimate of the distance to the goal state */
+        int h_F;
+        /** @brief heuristic estimate of the distance to the initial state */
+        int h_B;
+
+        /**
+         * @brief Constructor.
+         */
+        Node(State s, State pos, std::size_t hash, int blank, Move move, Direction dir, int h_F, int h_B)
+            : s(s), pos(pos), hash(hash), blank(blank), move(move), dir(dir), h_F(h_F), h_B(h_B)
+        {}
+
+        /**
+         * @brief Gets the heuristic value in the given direction.
+         */
+        int get_h(Direction d) const {
+            return (d == Direction::F) ? h_F : h_B;
+        }
+    };
+
     /**
-     * @brief Two nodes are equal iff their states s are the same.
+     * @brief Hash function for Node.
      */
-    bool operator()(const Node &node1, const Node &node2) const {
-        if (node1.s.size() != node2.s.size()) {
-            return false;
+    struct NodeHash {
+        /**
+         * @brief Hash a node based only on its state s, reading the hash it
+         * carries.
+         */
+        std::size_t operator()(const Node &node) const {
+            return node.hash;
         }
-        int s_size = node1.s.size();
-        for (int i = 0; i < s_size; ++i) {
-            if (node1.s[i] != node2.s[i]) {
-                return false;
+    };
+
+    /**
+     * @brief Equality function for Node.
+     */
+    struct NodeEqual {
+        /**
+         * @brief Two nodes are equal iff their states s are the same.
+         */
+        bool operator()(const Node &node1, const Node &node2) const {
+            return node1.s == node2.s;
+        }
+    };
+
+    /**
+     * @brief Manhattan distance or additive pattern database heuristic in
+     * each direction.
+     * 
+     * Built once per solve. The forward direction targets the goal state and
+     * the backward direction targets the initial state. Each direction uses
+     * the kind given to the constructor. With pattern
+     * databases, the tiles of a direction are split by the patterns of
+     * PatternDatabase::get_partition() that their target squares fall in,
+     * and h sums the entries of the patterns; tiles left out of every
+     * pattern, which only happens on a board without databases, count their
+     * Manhattan distance.
+     */
+    struct Heuristic {
+        /** @brief most patterns of a direction */
+        static constexpr int MAX_PATTERNS = 4;
+
+        /**
+         * @brief Pattern of one direction.
+         */
+        struct Pattern {
+            /** @brief database of the pattern */
+            const PatternDatabase<DIM> *pdb;
+            /** @brief number of tiles in the pattern */
+            int num_tiles;
+            /** @brief tile of every position within the pattern */
+            uint8_t tiles[NUM_SQUARES];
+        };
+
+        /** @brief row of every tile in the target state of each direction */
+        int target_row[2][NUM_SQUARES];
+        /** @brief column of every tile in the target state of each direction */
+        int target_col[2][NUM_SQUARES];
+        /**
+         * @brief dist[dir][tile][i] is the Manhattan distance from square i
+         * to the target square of the tile, or 0 if the tile is discounted
+         * or in a pattern
+         */
+        uint8_t dist[2][NUM_SQUARES][NUM_SQUARES];
+        /** @brief patterns of each direction */
+        Pattern patterns[2][MAX_PATTERNS];
+        /** @brief number of patterns of each direction */
+        int num_patterns[2];
+        /** @brief pattern of every tile in each direction, or -1 */
+        int8_t pattern_of[2][NUM_SQUARES];
+        /** @brief position of every tile within its pattern */
+        int8_t label_of[2][NUM_SQUARES];
+
+        Heuristic(State is, State gs, int discount, const HeuristicKinds &kinds);
+        static void prepare(State is, State gs, const HeuristicKinds &kinds);
+        int operator()(State s, Direction dir) const;
+        int get_pattern_delta(Direction dir, State pos, int tile, int from, int to) const;
+
+        /**
+         * @brief Gets the change in h_D when the tile moves between the
+         * given squares, where pos holds the squares of the tiles before the
+         * move.
+         */
+        int get_delta(Direction dir, State pos, int tile, int from, int to) const {
+            int delta = dist[dir][tile][to] - dist[dir][tile][from];
+            if (pattern_of[dir][tile] >= 0) {
+                delta += get_pattern_delta(dir, pos, tile, from, to);
             }
+            return delta;
         }
-        return true;
+    };
+
+    /* typedef for convenience */
+    typedef ArenaVector<Node> NodeVector;
+
+    /** @brief largest number of moves of a node */
+    static constexpr int MAX_MOVES = NUM_MOVES;
+
+    /**
+     * @brief Values of a node that unmake_move() restores.
+     */
+    struct Undo {
+        State pos;
+        std::size_t hash;
+        int blank;
+        Move move;
+        int h_F;
+        int h_B;
+    };
+
+    /**
+     * @brief Gets the number of moves of the node, including the one that
+     * undoes its own; make_move() takes an index below it.
+     */
+    static int get_num_moves(const Node &node) {
+        return BLANK_MOVES[node.blank].size;
+    }
+
+    /**
+     * @brief Gets the change in the Zobrist hash when the tile moves between
+     * the given squares.
+     */
+    static std::size_t get_hash_delta(int tile, int from, int to) {
+        return ZOBRIST[from][tile] ^ ZOBRIST[to][tile];
+    }
+
+    /**
+     * @brief Gets the change in the squares of the tiles when the tile and
+     * the empty square swap between the given squares.
+     */
+    static State get_pos_delta(int tile, int from, int to) {
+        State delta = from ^ to;
+        return (delta << (tile * SQUARE_BITS)) | delta;  // the empty square is tile 0
     }
-};
 
-/* typedef for convenience */
-typedef std::unordered_set<Node,NodeHash,NodeEqual> NodeSet;
-typedef std::unordered_map<Node,int,NodeHash,NodeEqual> NodeIntMap;
-typedef std::vector<Node> NodeVector;
-
-/* exported function prototypes */
-void print_node(const Node &node);
-void print_puzzle(const std::vector<int> &puzzle);
-
-bool is_solved(const std::vector<int> &s, const std::vector<int> &g);
-std::vector<int> make_move(const std::vector<int> &s, Move move);
-int h(const std::vector<int> &s, const std::vector<int> &g, int discount);
-NodeVector expand(const Node &node, int &nodes_expanded);
-int get_num_inversions(const std::vector<int> &s);
-
-bool get_pos(const std::vector<int> &s, int val, int &row, int &col);
-bool is_valid_up(int row);
-bool is_valid_down(int row);
-bool is_valid_left(int col);
-bool is_valid_right(int col);
\ No newline at end of file
+    /**
+     * @brief Gets the name used in experiment file names, e.g. "8puzzle".
+     */
+    static std::string get_name() {
+        return std::to_string(NUM_SQUARES - 1) + "puzzle";
+    }
+
+    /**
+     * @brief Gets the byte that stores keep beside a node's state to rebuild
+     * it: the index of its empty square.
+     */
+    static uint8_t get_aux(const Node &node) {
+        return node.blank;
+    }
+
+    /**
+     * @brief Rebuilds a node from the values that stores keep. The squares
+     * of the tiles are not kept, so they are recomputed from the state.
+     */
+    static Node make_node(State s, std::size_t hash, uint8_t aux, uint8_t move, Direction dir, int h_F, int h_B) {
+        return Node(s, get_tile_squares(s), hash, aux, static_cast<Move>(move), dir, h_F, h_B);
+    }
+
+    /**
+     * @brief Gets the row corresponding to the given index.
+     */
+    static constexpr int index_to_row(int i) {
+        return i / DIM;
+    }
+
+    /**
+     * @brief Gets the column corresponding to the given index.
+     */
+    static constexpr int index_to_col(int i) {
+        return i % DIM;
+    }
+
+    /**
+     * @brief Gets the index corresponding to the given row and column.
+     */
+    static constexpr int row_col_to_index(int row, int col) {
+        return row * DIM + col;
+    }
+
+    /* exported function prototypes */
+    static void print_node(const Node &node);
+    static void print_state(State puzzle);
+
+    static State pack(const std::vector<int> &puzzle);
+    static std::vector<int> unpack(State s);
+    static int get_square(State s, int i);
+    static std::size_t get_hash(State s);
+    static State get_tile_squares(State s);
+
+    static bool is_solved(State s, State g);
+    static State make_move(State s, Move move);
+    static State swap_blank(State s, int blank, int to);
+    static int get_blank(State s);
+    static Node make_root(State s, Direction dir, const Heuristic &heuristic);
+    static NodeVector expand(const Node &node, const Heuristic &heuristic, Counters &counters);
+    static bool make_move(Node &node, int k, const Heuristic &heuristic, Undo &undo);
+    static void unmake_move(Node &node, const Undo &undo);
+    static int get_num_inversions(State s);
+    static bool is_solvable(State s, State g);
+
+    static bool get_pos(State s, int val, int &row, int &col);
+};
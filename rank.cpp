@@ -0,0 +1,128 @@
+/**
+ * @file rank.cpp
+ * @brief Implementation of ranking and unranking n-puzzle states.
+ * 
+ * @author Andrew Gu (andrewg2)
+ * @bug No known bugs.
+ */
+
+#include "rank.h"
+
+#include <assert.h>
+
+/**
+ * @brief Builds the place values of the Lehmer digits of P.
+ * 
+ * The last two digits are dropped, so every place value is halved.
+ * 
+ * @return Table whose k-th entry is (NUM_TILES - 1 - k)! / 2.
+ */
+template <class P>
+constexpr std::array<uint64_t, P::NUM_SQUARES - 1> make_place_values() {
+    std::array<uint64_t, P::NUM_SQUARES - 1> values {};
+    for (int k = 0; k < P::NUM_SQUARES - 1; ++k) {
+        values[k] = factorial(P::NUM_SQUARES - 2 - k) / 2;
+    }
+    return values;
+}
+
+/** @brief place values of the Lehmer digits of P */
+template <class P>
+constexpr std::array<uint64_t, P::NUM_SQUARES - 1> PLACE_VALUES = make_place_values<P>();
+
+/**
+ * @brief Ranks the given state.
+ * 
+ * Runs in O(n) by counting the smaller tiles already read with a popcount
+ * instead of comparing against every later tile.
+ * 
+ * @param s Puzzle state.
+ * @return Rank in [0, NUM_RANKS<P>).
+ */
+template <class P>
+uint64_t rank(typename P::State s) {
+    static_assert(P::NUM_SQUARES % 2 == 1, "ranking requires a board of odd width");
+    constexpr int NUM_TILES = P::NUM_SQUARES - 1;
+    uint64_t r = 0;
+    uint32_t seen = 0;  // bit v is set once tile v has been read
+    int blank = 0;
+    int k = 0;  // number of tiles read so far
+    for (int i = 0; i < P::NUM_SQUARES; ++i) {
+        int v = P::get_square(s, i);
+        if (v == 0) {
+            blank = i;
+            continue;
+        }
+        if (k < NUM_TILES - 2) {
+            /* tiles smaller than v that have not been read yet come later */
+            int digit = (v - 1) - __builtin_popcount(seen & ((1u << v) - 1));
+            r += digit * PLACE_VALUES<P>[k];
+        }
+        seen |= 1u << v;
+        k++;
+    }
+    return blank * NUM_TILE_RANKS<P> + r;
+}
+
+/**
+ * @brief Unranks the given rank.
+ * 
+ * @param r Rank in [0, NUM_RANKS<P>).
+ * @param parity Parity of the number of tile inversions of the state, which
+ * decides the order of the last two tiles.
+ * @return Puzzle state s with rank(s) == r and get_parity(s) == parity.
+ */
+template <class P>
+typename P::State unrank(uint64_t r, int parity) {
+    constexpr int NUM_TILES = P::NUM_SQUARES - 1;
+    assert(r < NUM_RANKS<P>);
+    int blank = r / NUM_TILE_RANKS<P>;
+    r %= NUM_TILE_RANKS<P>;
+
+    int tiles[NUM_TILES];
+    uint32_t unused = ((1u << NUM_TILES) - 1) << 1;  // tiles 1, ..., NUM_TILES
+    int digit_sum = 0;
+    for (int k = 0; k < NUM_TILES - 2; ++k) {
+        int digit = r / PLACE_VALUES<P>[k];
+        r %= PLACE_VALUES<P>[k];
+        digit_sum += digit;
+        /* the tile is the digit-th smallest unused tile */
+        uint32_t rest = unused;
+        for (int j = 0; j < digit; ++j) {
+            rest &= rest - 1;
+        }
+        tiles[k] = __builtin_ctz(rest);
+        unused &= ~(1u << tiles[k]);
+    }
+
+    /* each Lehmer digit counts inversions, so the last one fixes the parity */
+    int low = __builtin_ctz(unused);
+    int high = 31 - __builtin_clz(unused);
+    bool swap_last = (digit_sum + parity) % 2 != 0;
+    tiles[NUM_TILES - 2] = swap_last ? high : low;
+    tiles[NUM_TILES - 1] = swap_last ? low : high;
+
+    typename P::State s = 0;
+    for (int i = 0, k = 0; i < P::NUM_SQUARES; ++i) {
+        if (i != blank) {
+            s |= (typename P::State) tiles[k++] << (i * P::SQUARE_BITS);
+        }
+    }
+    return s;
+}
+
+/**
+ * @brief Gets the parity of the number of tile inversions of the given state.
+ * 
+ * @param s Puzzle state.
+ * @return 0 if the number of inversions is even; 1 otherwise.
+ */
+template <class P>
+int get_parity(typename P::State s) {
+    return P::get_num_inversions(s) % 2;
+}
+
+/* explicit instantiations */
+template uint64_t rank<Puzzle<3>>(Puzzle<3>::State);
+template Puzzle<3>::State unrank<Puzzle<3>>(uint64_t, int);
+template int get_parity<Puzzle<3>>(Puzzle<3>::State);
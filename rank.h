@@ -0,0 +1,41 @@
+/**
+ * @file rank.h
+ * @brief Function prototypes for ranking and unranking n-puzzle states.
+ * 
+ * A state is ranked by the index of its empty square and the Lehmer code of
+ * its tiles read in row-major order, skipping the empty square. Moves never
+ * change the parity of the tile permutation on boards of odd width, so only
+ * half of the tile orderings are reachable and the last Lehmer digit is
+ * implied by the parity. This maps the reachable states of the 8-puzzle onto
+ * [0, 181440) with no gaps.
+ * 
+ * @author Andrew Gu (andrewg2)
+ * @bug No known bugs.
+ */
+
+#pragma once
+
+#include "puzzle.h"
+
+/**
+ * @brief Computes n! at compile time.
+ */
+constexpr uint64_t factorial(int n) {
+    return n <= 1 ? 1 : n * factorial(n - 1);
+}
+
+/** @brief number of tile orderings of P with a fixed parity */
+template <class P>
+constexpr uint64_t NUM_TILE_RANKS = factorial(P::NUM_SQUARES - 1) / 2;
+
+/** @brief number of states of P with a fixed tile parity */
+template <class P>
+constexpr uint64_t NUM_RANKS = P::NUM_SQUARES * NUM_TILE_RANKS<P>;
+
+/* exported function prototypes */
+template <class P>
+uint64_t rank(typename P::State s);
+template <class P>
+typename P::State unrank(uint64_t r, int parity);
+template <class P>
+int get_parity(typename P::State s);
@@ -0,0 +1,292 @@
+/**
+ * @file stack.h
+ * @brief Byte-packed pancake stacks with vectorized flip, compare and hash.
+ *
+ * A stack of up to CAP pancakes is stored one byte per pancake, top first,
+ * in CAP bytes that are a multiple of 16, so a stack of 16 pancakes fills
+ * one SSE register and a stack of 64 fills four. The plate is implied and
+ * the bytes past the last pancake are zero; a flip never reaches them, so
+ * whole registers can be compared and hashed.
+ *
+ * Each operation has a scalar version and, when the compiler targets
+ * SSE4.2 (make SIMD=1, the default), a vectorized one: the prefix reversal
+ * is a byte shuffle, equality compares whole registers and the hash is a
+ * CRC32 of the stack's words. flip(), operator== and get_hash() pick the
+ * vectorized version whenever it is built, and fall back to the scalar one
+ * otherwise.
+ *
+ * @author Andrew Gu (andrewg2)
+ * @bug No known bugs.
+ */
+
+#pragma once
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <assert.h>
+
+#if defined(__SSE4_2__)
+#include <immintrin.h>
+/** @brief whether the vectorized stack operations are built */
+#define STACK_SIMD (1)
+#else
+#define STACK_SIMD (0)
+#endif
+
+/**
+ * @brief Byte-packed pancake stack.
+ */
+template <int CAP>
+struct alignas(16) Stack {
+    static_assert(CAP % 16 == 0 && CAP >= 16 && CAP <= 64, "unsupported stack capacity");
+
+    /** @brief pancakes from top to bottom, then zeros */
+    uint8_t p[CAP];
+};
+
+/**
+ * @brief Packs a pancake stack.
+ *
+ * @param s Pancake stack ordered from top to bottom, ending with the plate.
+ * @return Packed stack.
+ * @pre s holds at most CAP pancakes besides the plate.
+ */
+template <int CAP>
+Stack<CAP> pack_stack(const std::vector<int> &s) {
+    assert(!s.empty() && s.size() - 1 <= CAP);
+    Stack<CAP> stack {};
+    for (std::size_t i = 0; i + 1 < s.size(); ++i) {
+        stack.p[i] = s[i];
+    }
+    return stack;
+}
+
+/**
+ * @brief Unpacks a pancake stack.
+ *
+ * @param stack Packed stack.
+ * @param n Number of pancakes, which is also the value of the plate.
+ * @return Pancake stack ordered from top to bottom, ending with the plate.
+ */
+template <int CAP>
+std::vector<int> unpack_stack(const Stack<CAP> &stack, int n) {
+    std::vector<int> s(stack.p, stack.p + n);
+    s.push_back(n);
+    return s;
+}
+
+/**
+ * @brief Performs a k-flip one byte at a time.
+ *
+ * @param stack Packed stack.
+ * @param k Index to flip; pancakes 0 through k are reversed.
+ * @return Packed stack after the flip.
+ */
+template <int CAP>
+Stack<CAP> flip_scalar(const Stack<CAP> &stack, int k) {
+    assert(k >= 1 && k < CAP);
+    Stack<CAP> s_flip = stack;
+    std::reverse(s_flip.p, s_flip.p + k + 1);
+    return s_flip;
+}
+
+/**
+ * @brief Compares two stacks one byte at a time.
+ */
+template <int CAP>
+bool equal_scalar(const Stack<CAP> &a, const Stack<CAP> &b) {
+    return std::memcmp(a.p, b.p, CAP) == 0;
+}
+
+/**
+ * @brief Hashes a stack by folding its words with a multiply-xorshift mix.
+ */
+template <int CAP>
+std::size_t hash_scalar(const Stack<CAP> &stack) {
+    uint64_t hash = CAP;
+    for (int i = 0; i < CAP; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, stack.p + i, 8);
+        hash = (hash ^ word) * 0x9e3779b97f4a7c15ULL;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+#if STACK_SIMD
+
+/** @brief shuffle masks of the flips within one register, see FLIP_MASKS */
+typedef std::array<std::array<uint8_t, 16>, 16> FlipMaskTable;
+
+/**
+ * @brief Builds the shuffle masks of the flips within one register.
+ *
+ * @return Table mapping k to the mask that reverses bytes 0 through k and
+ * keeps the others.
+ */
+constexpr FlipMaskTable make_flip_mask_table() {
+    FlipMaskTable table {};
+    for (int k = 0; k < 16; ++k) {
+        for (int i = 0; i < 16; ++i) {
+            table[k][i] = (i <= k) ? k - i : i;
+        }
+    }
+    return table;
+}
+
+/** @brief FLIP_MASKS[k] reverses bytes 0 through k of a register */
+constexpr FlipMaskTable FLIP_MASKS = make_flip_mask_table();
+
+/**
+ * @brief Windows of shuffle and blend masks, see flip_simd().
+ *
+ * SHIFT_WINDOW[16 + off, 32 + off) moves bytes off through 15 of a register
+ * to the front and SHIFT_WINDOW[off, 16 + off) moves bytes 0 through off - 1
+ * to the back, zeroing the rest. KEEP_WINDOW[16 - t, 32 - t) selects the
+ * first t bytes of a register.
+ */
+alignas(16) constexpr uint8_t SHIFT_WINDOW[48] = {
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80
+};
+alignas(16) constexpr uint8_t KEEP_WINDOW[32] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+/**
+ * @brief Loads 16 bytes from an arbitrary address.
+ */
+inline __m128i load_window(const uint8_t *p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+/**
+ * @brief Performs a k-flip with byte shuffles.
+ *
+ * A flip within the first register is a single shuffle. A longer flip over
+ * m registers reverses each of them and takes them in reverse order, which
+ * yields the flipped prefix shifted by off = 16m - (k + 1) bytes; each
+ * output register is then stitched from two neighbouring reversed ones,
+ * and the pancakes below the flip are blended back into the last one.
+ *
+ * @param stack Packed stack.
+ * @param k Index to flip; pancakes 0 through k are reversed.
+ * @return Packed stack after the flip.
+ */
+template <int CAP>
+Stack<CAP> flip_simd(const Stack<CAP> &stack, int k) {
+    assert(k >= 1 && k < CAP);
+    Stack<CAP> s_flip = stack;
+    const __m128i *in = reinterpret_cast<const __m128i *>(stack.p);
+    __m128i *out = reinterpret_cast<__m128i *>(s_flip.p);
+    if (k < 16) {
+        _mm_store_si128(out, _mm_shuffle_epi8(_mm_load_si128(in), load_window(FLIP_MASKS[k].data())));
+        return s_flip;
+    }
+
+    int len = k + 1;
+    int m = (len + 15) / 16;  // registers touched by the flip
+    int off = 16 * m - len;
+    const __m128i reverse = load_window(FLIP_MASKS[15].data());
+    __m128i rev[CAP / 16 + 1];
+    for (int c = 0; c < m; ++c) {
+        rev[c] = _mm_shuffle_epi8(_mm_load_si128(in + (m - 1 - c)), reverse);
+    }
+    rev[m] = _mm_setzero_si128();
+
+    const __m128i front = load_window(SHIFT_WINDOW + 16 + off);
+    const __m128i back = load_window(SHIFT_WINDOW + off);
+    for (int c = 0; c < m; ++c) {
+        __m128i shifted = _mm_or_si128(_mm_shuffle_epi8(rev[c], front), _mm_shuffle_epi8(rev[c + 1], back));
+        if (c < m - 1) {
+            _mm_store_si128(out + c, shifted);
+        } else {
+            __m128i keep = load_window(KEEP_WINDOW + 16 - (len - 16 * c));
+            _mm_store_si128(out + c, _mm_blendv_epi8(_mm_load_si128(in + c), shifted, keep));
+        }
+    }
+    return s_flip;
+}
+
+/**
+ * @brief Compares two stacks a register at a time.
+ */
+template <int CAP>
+bool equal_simd(const Stack<CAP> &a, const Stack<CAP> &b) {
+    const __m128i *x = reinterpret_cast<const __m128i *>(a.p);
+    const __m128i *y = reinterpret_cast<const __m128i *>(b.p);
+    __m128i eq = _mm_cmpeq_epi8(_mm_load_si128(x), _mm_load_si128(y));
+    for (int c = 1; c < CAP / 16; ++c) {
+        eq = _mm_and_si128(eq, _mm_cmpeq_epi8(_mm_load_si128(x + c), _mm_load_si128(y + c)));
+    }
+    return _mm_movemask_epi8(eq) == 0xffff;
+}
+
+/**
+ * @brief Hashes a stack with the CRC32 instruction, one word at a time.
+ */
+template <int CAP>
+std::size_t hash_crc32(const Stack<CAP> &stack) {
+    uint64_t crc = 0;
+    for (int i = 0; i < CAP; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, stack.p + i, 8);
+        crc = _mm_crc32_u64(crc, word);
+    }
+    return crc;
+}
+
+#endif
+
+/**
+ * @brief Performs a k-flip on the packed stack.
+ *
+ * @param stack Packed stack.
+ * @param k Index to flip; pancakes 0 through k are reversed.
+ * @return Packed stack after the flip.
+ */
+template <int CAP>
+Stack<CAP> flip(const Stack<CAP> &stack, int k) {
+#if STACK_SIMD
+    return flip_simd(stack, k);
+#else
+    return flip_scalar(stack, k);
+#endif
+}
+
+/**
+ * @brief Two packed stacks are equal iff all their bytes are.
+ */
+template <int CAP>
+bool operator==(const Stack<CAP> &a, const Stack<CAP> &b) {
+#if STACK_SIMD
+    return equal_simd(a, b);
+#else
+    return equal_scalar(a, b);
+#endif
+}
+
+/**
+ * @brief Two packed stacks differ iff any of their bytes do.
+ */
+template <int CAP>
+bool operator!=(const Stack<CAP> &a, const Stack<CAP> &b) {
+    return !(a == b);
+}
+
+/**
+ * @brief Hashes the packed stack.
+ */
+template <int CAP>
+std::size_t get_hash(const Stack<CAP> &stack) {
+#if STACK_SIMD
+    return hash_crc32(stack);
+#else
+    return hash_scalar(stack);
+#endif
+}
@@ -0,0 +1,622 @@
+/**
+ * @file store.h
+ * @brief Storage policies for the open/closed sets and g-values of the
+ * search algorithms.
+ * 
+ * The search algorithms are templated over a store, which tracks g_F, g_B
+ * and membership in open_F, open_B, closed_F and closed_B for every state
+ * seen so far. A state is looked up once with find() or insert(), which
+ * take the state together with the hash its node carries and return
+ * a handle to its entry, and every other query reads that entry:
+ * 
+ *     find(s, hash), insert(s, hash), is_open(h, dir), is_closed(h, dir),
+ *     has_g(h, dir), get_g(h, dir), set_g(h, dir, g), open(h, node, dir),
+ *     mark_open(h, node, dir), close(h, dir), open_empty(dir),
+ *     for_each_open(dir, gLim, fLim, fn), clear()
+ * 
+ * Handles are invalidated by the next call to insert(). open() takes a
+ * whole node so that the nodes passed to for_each_open() keep their cached
+ * heuristic values, the domain's auxiliary byte and the move that generated
+ * them through their cheapest known parent. open() must be called after
+ * set_g(), since open sets are kept in buckets indexed by (g_D, h_D).
+ * Algorithms with an open list of their own, such as MMe, call mark_open()
+ * instead, which sets the same flags and values but lists the node in no
+ * bucket, and never call for_each_open().
+ * 
+ * @author Andrew Gu (andrewg2)
+ * @bug No known bugs.
+ */
+
+#pragma once
+
+#include "domain.h"
+#include "arena.h"
+#include "rank.h"
+
+#include <algorithm>
+#include <assert.h>
+
+/** @brief handle to the entry of a state in a store */
+typedef std::size_t Handle;
+
+/** @brief handle returned by find() for a state without an entry */
+const Handle NOT_FOUND = SIZE_MAX;
+
+/**
+ * @brief Flag bits of a store entry, shifted left by the direction.
+ */
+enum StoreFlag : uint8_t {
+    OPEN = 1 << 0,
+    CLOSED = 1 << 2,
+};
+
+/**
+ * @brief Open list of one direction organized as buckets indexed by (g, h).
+ * 
+ * Nodes that satisfy g < gLim and g + h <= fLim are read straight from the
+ * buckets below those limits, without touching the rest of the open set.
+ * Entries are never removed eagerly: the owning store reports through the
+ * callback of scan() whether an entry is still open with the g-value of
+ * its bucket, and stale entries are dropped as they are met.
+ */
+template <class T>
+class OpenBuckets {
+public:
+    /**
+     * @brief Adds the item to bucket (g, h).
+     */
+    void push(const T &item, int g, int h) {
+        assert(g >= 0 && h >= 0);
+        if (g >= static_cast<int>(buckets_.size())) {
+            buckets_.resize(g + 1);
+        }
+        ArenaVector<ArenaVector<T>> &row = buckets_[g];
+        if (h >= static_cast<int>(row.size())) {
+            row.resize(h + 1);
+        }
+        row[h].push_back(item);
+    }
+
+    /**
+     * @brief Calls keep(item, g, h) on every entry of the buckets with
+     * g < gLim and g + h <= fLim, dropping the entries for which it returns
+     * false.
+     */
+    template <class Keep>
+    void scan(int gLim, int fLim, Keep keep) {
+        int g_end = std::min(gLim, static_cast<int>(buckets_.size()));
+        for (int g = 0; g < g_end && g <= fLim; ++g) {
+            ArenaVector<ArenaVector<T>> &row = buckets_[g];
+            int h_end = std::min(fLim - g, static_cast<int>(row.size()) - 1);
+            for (int h = 0; h <= h_end; ++h) {
+                ArenaVector<T> &bucket = row[h];
+                std::size_t kept = 0;
+                for (std::size_t i = 0; i < bucket.size(); ++i) {
+                    if (keep(bucket[i], g, h)) {
+                        bucket[kept++] = bucket[i];
+                    }
+                }
+                bucket.erase(bucket.begin() + kept, bucket.end());
+            }
+        }
+    }
+
+    /**
+     * @brief Replaces every entry with map(entry), keeping the order of the
+     * entries.
+     */
+    template <class Map>
+    void remap(Map map) {
+        for (ArenaVector<ArenaVector<T>> &row : buckets_) {
+            for (ArenaVector<T> &bucket : row) {
+                for (T &item : bucket) {
+                    item = map(item);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Removes every entry, keeping the buckets allocated.
+     */
+    void clear() {
+        for (ArenaVector<ArenaVector<T>> &row : buckets_) {
+            for (ArenaVector<T> &bucket : row) {
+                bucket.clear();
+            }
+        }
+    }
+
+private:
+    /** @brief buckets_[g][h] holds the entries of bucket (g, h) */
+    ArenaVector<ArenaVector<ArenaVector<T>>> buckets_;
+};
+
+/**
+ * @brief Store backed by a single open-addressing hash table.
+ * 
+ * Each slot holds a packed state and its hash together with everything the
+ * algorithms know about it in both directions: g_F, g_B, the cached
+ * heuristic values, the domain's auxiliary byte, the move that generated it
+ * and the open/closed flags. Moving a node between open and closed is a flag
+ * flip, and a successor's duplicate check, cost update and collision check
+ * all read the same slot. Open sets are iterated through (g, h) buckets of
+ * slot indices, and the nodes they list carry the hash kept in the slot.
+ * 
+ * Slots are stamped with the solve that filled them, and a slot with an
+ * older stamp is free, so clear() does not have to touch the slots that a
+ * larger instance left allocated.
+ */
+template <class P>
+class HashStore {
+public:
+    typedef P Domain;
+    typedef typename P::State State;
+    typedef typename P::Node Node;
+
+    /**
+     * @brief Constructor.
+     */
+    HashStore()
+        : slots_(MIN_CAPACITY), size_(0), stamp_(1)
+    {
+        num_open_[Direction::F] = 0;
+        num_open_[Direction::B] = 0;
+    }
+
+    /**
+     * @brief Removes every entry, keeping the table allocated.
+     */
+    void clear() {
+        stamp_++;
+        if (stamp_ == 0) {
+            std::fill(slots_.begin(), slots_.end(), Slot());
+            stamp_ = 1;
+        }
+        size_ = 0;
+        num_open_[Direction::F] = 0;
+        num_open_[Direction::B] = 0;
+        open_list_[Direction::F].clear();
+        open_list_[Direction::B].clear();
+    }
+
+    /**
+     * @brief Finds the entry of the state with the given hash.
+     * 
+     * @return Handle to the entry, or NOT_FOUND.
+     */
+    Handle find(const State &s, std::size_t hash) const {
+        std::size_t mask = slots_.size() - 1;
+        for (std::size_t i = hash & mask; ; i = (i + 1) & mask) {
+            const Slot &slot = slots_[i];
+            if (slot.stamp != stamp_) {
+                return NOT_FOUND;
+            }
+            if (slot.s == s) {
+                return i;
+            }
+        }
+    }
+
+    /**
+     * @brief Finds the entry of the state with the given hash, creating it
+     * if there is none.
+     * 
+     * @return Handle to the entry.
+     */
+    Handle insert(const State &s, std::size_t hash) {
+        if (2 * (size_ + 1) > slots_.size()) {
+            grow();
+        }
+        std::size_t mask = slots_.size() - 1;
+        std::size_t i = hash & mask;
+        while (slots_[i].stamp == stamp_) {
+            if (slots_[i].s == s) {
+                return i;
+            }
+            i = (i + 1) & mask;
+        }
+        slots_[i] = Slot();
+        slots_[i].s = s;
+        slots_[i].hash = hash;
+        slots_[i].stamp = stamp_;
+        size_++;
+        return i;
+    }
+
+    /**
+     * @brief Checks if the state is in open_D.
+     */
+    bool is_open(Handle h, Direction dir) const {
+        return slots_[h].flags & (OPEN << dir);
+    }
+
+    /**
+     * @brief Checks if the state is in closed_D.
+     */
+    bool is_closed(Handle h, Direction dir) const {
+        return slots_[h].flags & (CLOSED << dir);
+    }
+
+    /**
+     * @brief Checks if the state has a g-value in direction D.
+     */
+    bool has_g(Handle h, Direction dir) const {
+        return slots_[h].g[dir] != G_NONE;
+    }
+
+    /**
+     * @brief Gets g_D of the state.
+     * @pre has_g(h, dir).
+     */
+    int get_g(Handle h, Direction dir) const {
+        assert(has_g(h, dir));
+        return slots_[h].g[dir];
+    }
+
+    /**
+     * @brief Sets g_D of the state.
+     */
+    void set_g(Handle h, Direction dir, int g) {
+        assert(g >= 0 && g <= INT16_MAX);
+        slots_[h].g[dir] = g;
+    }
+
+    /**
+     * @brief Moves the node into open_D, removing it from closed_D, and
+     * lists it for for_each_open().
+     */
+    void open(Handle h, const Node &node, Direction dir) {
+        mark_open(h, node, dir);
+        open_list_[dir].push(h, slots_[h].g[dir], slots_[h].h[dir]);
+    }
+
+    /**
+     * @brief Moves the node into open_D, removing it from closed_D, without
+     * listing it for for_each_open().
+     */
+    void mark_open(Handle h, const Node &node, Direction dir) {
+        Slot &slot = slots_[h];
+        assert(slot.s == node.s);
+        slot.aux = P::get_aux(node);
+        slot.move[dir] = node.move;
+        slot.h[Direction::F] = node.h_F;
+        slot.h[Direction::B] = node.h_B;
+        slot.flags &= ~(CLOSED << dir);
+        if (!(slot.flags & (OPEN << dir))) {
+            slot.flags |= OPEN << dir;
+            num_open_[dir]++;
+        }
+    }
+
+    /**
+     * @brief Moves the state into closed_D, removing it from open_D.
+     */
+    void close(Handle h, Direction dir) {
+        Slot &slot = slots_[h];
+        if (slot.flags & (OPEN << dir)) {
+            slot.flags &= ~(OPEN << dir);
+            num_open_[dir]--;
+        }
+        slot.flags |= CLOSED << dir;
+    }
+
+    /**
+     * @brief Checks if open_D is empty.
+     */
+    bool open_empty(Direction dir) const {
+        return num_open_[dir] == 0;
+    }
+
+    /**
+     * @brief Calls fn(node, g_D) on every node in open_D with g_D < gLim and
+     * g_D + h_D <= fLim.
+     * 
+     * Only the buckets below the limits are read. fn must not modify the
+     * store.
+     */
+    template <class Fn>
+    void for_each_open(Direction dir, int gLim, int fLim, Fn fn) {
+        open_list_[dir].scan(gLim, fLim, [&](Handle h, int g, int) {
+            const Slot &slot = slots_[h];
+            if (!(slot.flags & (OPEN << dir)) || slot.g[dir] != g) {
+                return false;
+            }
+            fn(P::make_node(slot.s, slot.hash, slot.aux, slot.move[dir], dir, slot.h[Direction::F], slot.h[Direction::B]), g);
+            return true;
+        });
+    }
+
+private:
+    /** @brief initial number of slots, a power of two */
+    static const std::size_t MIN_CAPACITY = 1024;
+    /** @brief g-value of a state that has not been reached */
+    static const int16_t G_NONE = -1;
+
+    /**
+     * @brief Table slot.
+     */
+    struct Slot {
+        /** @brief packed state */
+        State s;
+        /** @brief hash of s, as carried by its nodes */
+        std::size_t hash;
+        /** @brief g_F and g_B, or G_NONE */
+        int16_t g[2];
+        /** @brief cached h_F and h_B */
+        uint8_t h[2];
+        /** @brief move that generated the state in each direction */
+        uint8_t move[2];
+        /** @brief auxiliary byte of the domain, see P::get_aux() */
+        uint8_t aux;
+        /** @brief OPEN and CLOSED bits for both directions */
+        uint8_t flags;
+        /** @brief stamp of the solve that filled the slot, or 0 */
+        uint32_t stamp;
+
+        /**
+         * @brief Constructor.
+         */
+        Slot()
+            : s(), hash(0), aux(0), flags(0), stamp(0)
+        {
+            g[Direction::F] = G_NONE;
+            g[Direction::B] = G_NONE;
+            h[Direction::F] = 0;
+            h[Direction::B] = 0;
+            move[Direction::F] = P::NO_MOVE;
+            move[Direction::B] = P::NO_MOVE;
+        }
+    };
+
+    /**
+     * @brief Doubles the number of slots and rehashes every entry.
+     * 
+     * Slot indices change, so the entries of the open buckets are mapped to
+     * the new indices in place. This keeps the order in which for_each_open()
+     * visits nodes independent of how often the table has grown, so a solve
+     * does not depend on the capacity left by earlier solves. Entries are
+     * placed by the hashes kept in their slots, so no state is rehashed.
+     */
+    void grow() {
+        ArenaVector<Slot> old_slots(2 * slots_.size());
+        old_slots.swap(slots_);
+        std::size_t mask = slots_.size() - 1;
+        ArenaVector<Handle> moved(old_slots.size(), NOT_FOUND);
+        for (std::size_t j = 0; j < old_slots.size(); ++j) {
+            const Slot &slot = old_slots[j];
+            if (slot.stamp != stamp_) {
+                continue;
+            }
+            std::size_t i = slot.hash & mask;
+            while (slots_[i].stamp == stamp_) {
+                i = (i + 1) & mask;
+            }
+            slots_[i] = slot;
+            moved[j] = i;
+        }
+        for (int dir = Direction::F; dir <= Direction::B; ++dir) {
+            open_list_[dir].remap([&](Handle h) {
+                assert(moved[h] != NOT_FOUND);
+                return moved[h];
+            });
+        }
+    }
+
+    ArenaVector<Slot> slots_;
+    std::size_t size_;
+    /** @brief stamp of the current solve */
+    uint32_t stamp_;
+    OpenBuckets<Handle> open_list_[2];
+    int num_open_[2];
+};
+
+/**
+ * @brief Store backed by flat arrays indexed by rank.
+ * 
+ * Every reachable state of the 8-puzzle has an entry of six bytes, and its
+ * handle is its rank, so a lookup is a rank computation plus an array read,
+ * with no hashing or allocation. Open sets are iterated through (g, h)
+ * buckets of nodes, skipping nodes that have been closed or reached more
+ * cheaply since they were listed. The listed copy of a node is only
+ * trusted for values determined by its state; the move that generated it
+ * is kept in its entry.
+ * 
+ * As in HashStore, entries are stamped with the solve that last inserted
+ * them, and an entry with an older stamp reads as unreached, so clear()
+ * only resets the array once every 255 solves, when the stamp wraps.
+ */
+template <class P>
+class DenseStore {
+public:
+    typedef P Domain;
+    typedef typename P::State State;
+    typedef typename P::Node Node;
+
+    static_assert(NUM_RANKS<P> <= (1 << 24), "board too large for a dense store");
+
+    /**
+     * @brief Constructor.
+     */
+    DenseStore()
+        : entries_(NUM_RANKS<P>), stamp_(1)
+    {
+        num_open_[Direction::F] = 0;
+        num_open_[Direction::B] = 0;
+    }
+
+    /**
+     * @brief Removes every entry, keeping the arrays allocated.
+     */
+    void clear() {
+        stamp_++;
+        if (stamp_ == 0) {
+            std::fill(entries_.begin(), entries_.end(), Entry());
+            stamp_ = 1;
+        }
+        num_open_[Direction::F] = 0;
+        num_open_[Direction::B] = 0;
+        open_list_[Direction::F].clear();
+        open_list_[Direction::B].clear();
+    }
+
+    /**
+     * @brief Finds the entry of the state; the hash is not needed.
+     * 
+     * @return Handle to the entry, which always exists.
+     */
+    Handle find(State s, std::size_t) const {
+        return rank<P>(s);
+    }
+
+    /**
+     * @brief Finds the entry of the state; the hash is not needed. An entry
+     * left by an earlier solve is reset.
+     * 
+     * @return Handle to the entry.
+     */
+    Handle insert(State s, std::size_t) {
+        Handle h = rank<P>(s);
+        Entry &entry = entries_[h];
+        if (entry.stamp != stamp_) {
+            entry = Entry();
+            entry.stamp = stamp_;
+        }
+        return h;
+    }
+
+    /**
+     * @brief Checks if the state is in open_D.
+     */
+    bool is_open(Handle h, Direction dir) const {
+        return entries_[h].stamp == stamp_ && (entries_[h].flags & (OPEN << dir));
+    }
+
+    /**
+     * @brief Checks if the state is in closed_D.
+     */
+    bool is_closed(Handle h, Direction dir) const {
+        return entries_[h].stamp == stamp_ && (entries_[h].flags & (CLOSED << dir));
+    }
+
+    /**
+     * @brief Checks if the state has a g-value in direction D.
+     */
+    bool has_g(Handle h, Direction dir) const {
+        return entries_[h].stamp == stamp_ && entries_[h].g[dir] != G_NONE;
+    }
+
+    /**
+     * @brief Gets g_D of the state.
+     * @pre has_g(h, dir).
+     */
+    int get_g(Handle h, Direction dir) const {
+        assert(has_g(h, dir));
+        return entries_[h].g[dir];
+    }
+
+    /**
+     * @brief Sets g_D of the state.
+     */
+    void set_g(Handle h, Direction dir, int g) {
+        assert(g >= 0 && g < G_NONE);
+        entries_[h].g[dir] = g;
+    }
+
+    /**
+     * @brief Moves the node into open_D, removing it from closed_D, and
+     * lists it for for_each_open().
+     */
+    void open(Handle h, const Node &node, Direction dir) {
+        mark_open(h, node, dir);
+        open_list_[dir].push(node, entries_[h].g[dir], node.get_h(dir));
+    }
+
+    /**
+     * @brief Moves the node into open_D, removing it from closed_D, without
+     * listing it for for_each_open().
+     */
+    void mark_open(Handle h, const Node &node, Direction dir) {
+        Entry &entry = entries_[h];
+        entry.move[dir] = node.move;
+        entry.flags &= ~(CLOSED << dir);
+        if (!(entry.flags & (OPEN << dir))) {
+            entry.flags |= OPEN << dir;
+            num_open_[dir]++;
+        }
+    }
+
+    /**
+     * @brief Moves the state into closed_D, removing it from open_D.
+     */
+    void close(Handle h, Direction dir) {
+        Entry &entry = entries_[h];
+        if (entry.flags & (OPEN << dir)) {
+            entry.flags &= ~(OPEN << dir);
+            num_open_[dir]--;
+        }
+        entry.flags |= CLOSED << dir;
+    }
+
+    /**
+     * @brief Checks if open_D is empty.
+     */
+    bool open_empty(Direction dir) const {
+        return num_open_[dir] == 0;
+    }
+
+    /**
+     * @brief Calls fn(node, g_D) on every node in open_D with g_D < gLim and
+     * g_D + h_D <= fLim.
+     * 
+     * Only the buckets below the limits are read. fn must not modify the
+     * store.
+     */
+    template <class Fn>
+    void for_each_open(Direction dir, int gLim, int fLim, Fn fn) {
+        open_list_[dir].scan(gLim, fLim, [&](Node &node, int g, int) {
+            const Entry &entry = entries_[rank<P>(node.s)];
+            if (!(entry.flags & (OPEN << dir)) || entry.g[dir] != g) {
+                return false;
+            }
+            fn(P::make_node(node.s, node.hash, P::get_aux(node), entry.move[dir], dir, node.h_F, node.h_B), g);
+            return true;
+        });
+    }
+
+private:
+    /** @brief g-value of a state that has not been reached */
+    static const int G_NONE = 0xff;
+
+    /**
+     * @brief Per-state entry.
+     */
+    struct Entry {
+        /** @brief g_F and g_B, or G_NONE */
+        uint8_t g[2];
+        /** @brief OPEN and CLOSED bits for both directions */
+        uint8_t flags;
+        /** @brief move that generated the state in each direction */
+        uint8_t move[2];
+        /** @brief stamp of the solve that last inserted the state, or 0 */
+        uint8_t stamp;
+
+        /**
+         * @brief Constructor.
+         */
+        Entry()
+            : flags(0), stamp(0)
+        {
+            g[Direction::F] = G_NONE;
+            g[Direction::B] = G_NONE;
+            move[Direction::F] = P::NO_MOVE;
+            move[Direction::B] = P::NO_MOVE;
+        }
+    };
+
+    ArenaVector<Entry> entries_;
+    /** @brief stamp of the current solve */
+    uint8_t stamp_;
+    OpenBuckets<Node> open_list_[2];
+    int num_open_[2];
+};